@@ -0,0 +1,506 @@
+#include "aot_compiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "aot_core.h"
+#include "chip_8.h"
+#include "rom_cache.h"
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8::memory8_4kb);
+
+static std::string Hex(unsigned int value, int digits) {
+  char text[16];
+  std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+  return text;
+}
+
+static std::string Label(unsigned int address) {
+  char text[16];
+  std::snprintf(text, sizeof(text), "L_%03X", address);
+  return text;
+}
+
+static std::string V(unsigned int reg) {
+  return "c.registers8_16[" + Hex(reg, 1) + "]";
+}
+
+static char const* QuirkEnumerator(QuirkProfile profile) {
+  switch (profile) {
+    case QUIRKS_COSMAC: return "QUIRKS_COSMAC";
+    case QUIRKS_SCHIP: return "QUIRKS_SCHIP";
+    case QUIRKS_XOCHIP: return "QUIRKS_XOCHIP";
+    default: return "QUIRKS_DEFAULT";
+  }
+}
+
+namespace {
+
+// Everything the recompiler knows about the ROM
+struct Program {
+  std::vector<uint8_t> memory = std::vector<uint8_t>(MEMORY_SIZE);
+  unsigned int end{};  // one past the last ROM byte
+
+  std::vector<bool> reachable = std::vector<bool>(MEMORY_SIZE);
+  std::vector<bool> leader = std::vector<bool>(MEMORY_SIZE);
+  std::vector<AotBlock> blocks;
+
+  // The ROM's QuirksForRom() profile, resolved into the generated code
+  QuirkProfile quirks{QUIRKS_DEFAULT};
+  bool shift_vy{};
+  bool load_store_increments_i{};
+  bool jump_vx{};
+  bool logic_resets_vf{};
+
+  bool InRom(unsigned int address) const {
+    return address >= START_ADDRESS && address + 1 < end;
+  }
+
+  uint16_t Opcode(unsigned int address) const {
+    return (memory[address] << 8u) | memory[address + 1];
+  }
+
+  // Jump to a block, or hand `address` back to AotCore
+  std::string Goto(unsigned int address) const {
+    if (InRom(address) && leader[address]) {
+      return "goto " + Label(address) + ";";
+    }
+
+    return "{ c.pc16 = " + Hex(address & 0xFFFFu, 3) + "; return budget; }";
+  }
+};
+
+enum Flow {
+  FLOW_NEXT,     // falls through
+  FLOW_JUMP,     // 1nnn
+  FLOW_CALL,     // 2nnn
+  FLOW_DYNAMIC,  // 00EE, Bnnn -> target only known at run time
+  FLOW_SKIP,     // 3xnn 4xnn 5xy0 9xy0 Ex9E ExA1
+  FLOW_WAIT,     // Fx0A -> halts on itself until a key is down
+  FLOW_STORE,    // Fx33 Fx55 -> may rewrite code that follows
+};
+
+}  // namespace
+
+// Same lookups as Chip8's table/table0/table8/tableE/tableF
+static Flow FlowOf(uint16_t opcode) {
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      return (opcode & 0x000Fu) == 0xE ? FLOW_DYNAMIC : FLOW_NEXT;
+    case 0x1: return FLOW_JUMP;
+    case 0x2: return FLOW_CALL;
+    case 0x3:
+    case 0x4:
+    case 0x5:
+    case 0x9: return FLOW_SKIP;
+    case 0xB: return FLOW_DYNAMIC;
+
+    case 0xE:
+      if ((opcode & 0x000Fu) == 0x1 || (opcode & 0x000Fu) == 0xE) {
+        return FLOW_SKIP;
+      }
+      return FLOW_NEXT;
+
+    case 0xF:
+      if ((opcode & 0x00FFu) == 0x0A) return FLOW_WAIT;
+      if ((opcode & 0x00FFu) == 0x33) return FLOW_STORE;
+      if ((opcode & 0x00FFu) == 0x55) return FLOW_STORE;
+      return FLOW_NEXT;
+  }
+
+  return FLOW_NEXT;
+}
+
+// Worklist walk from START_ADDRESS -> reachable instructions and leaders
+static void FindCode(Program& program) {
+  std::vector<unsigned int> work{START_ADDRESS};
+  program.leader[START_ADDRESS] = true;
+
+  auto Target = [&](unsigned int address) {
+    if (program.InRom(address)) {
+      program.leader[address] = true;
+      work.push_back(address);
+    }
+  };
+
+  while (!work.empty()) {
+    unsigned int address = work.back();
+    work.pop_back();
+
+    if (!program.InRom(address) || program.reachable[address]) {
+      continue;
+    }
+
+    program.reachable[address] = true;
+
+    uint16_t opcode = program.Opcode(address);
+    unsigned int next = address + 2;
+
+    switch (FlowOf(opcode)) {
+      case FLOW_NEXT: work.push_back(next); break;
+      case FLOW_JUMP: Target(opcode & 0x0FFFu); break;
+
+      case FLOW_CALL:
+        Target(opcode & 0x0FFFu);
+        Target(next);  // return address
+        break;
+
+      case FLOW_DYNAMIC:
+        // Bnnn: nnn is the V0 = 0 entry of the usual jump table
+        if ((opcode & 0xF000u) == 0xB000u) {
+          Target(opcode & 0x0FFFu);
+        }
+        break;
+
+      case FLOW_SKIP:
+        Target(next);
+        Target(next + 2);
+        break;
+
+      case FLOW_WAIT:
+        Target(address);
+        Target(next);
+        break;
+
+      case FLOW_STORE: Target(next); break;
+    }
+  }
+}
+
+// Cut the reachable code into blocks; a full block makes its successor a
+// leader, so leaders can only be added ahead of the scan
+static void FindBlocks(Program& program) {
+  for (unsigned int start = START_ADDRESS; start < program.end; ++start) {
+    if (!program.leader[start] || !program.reachable[start]) {
+      continue;
+    }
+
+    unsigned int address = start;
+    unsigned int count = 0;
+
+    while (true) {
+      Flow flow = FlowOf(program.Opcode(address));
+      address += 2;
+      ++count;
+
+      if (flow != FLOW_NEXT || !program.InRom(address) ||
+          !program.reachable[address] || program.leader[address]) {
+        break;
+      }
+
+      if (count == AOT_MAX_BLOCK_INSTRUCTIONS) {
+        program.leader[address] = true;
+        break;
+      }
+    }
+
+    program.blocks.push_back({static_cast<uint16_t>(start),
+                              static_cast<uint16_t>(address)});
+  }
+}
+
+// One instruction; state changes happen in the same order as in Chip8::Op_*
+static void EmitInstruction(Program const& program, unsigned int address,
+                            bool last, std::ostream& out) {
+  uint16_t opcode = program.Opcode(address);
+  unsigned int x = (opcode & 0x0F00u) >> 8u;
+  unsigned int y = (opcode & 0x00F0u) >> 4u;
+  std::string nn = Hex(opcode & 0x00FFu, 2);
+  unsigned int nnn = opcode & 0x0FFFu;
+  unsigned int next = address + 2;
+
+  std::string vx = V(x);
+  std::string vy = V(y);
+  std::string vf = V(0xF);
+
+  auto Skip = [&](std::string const& condition) {
+    out << "  if (" << condition << ") " << program.Goto(next + 2) << "\n"
+        << "  " << program.Goto(next) << "\n";
+  };
+
+  out << "  // " << Hex(address, 3) << ": " << Hex(opcode, 4) << "\n";
+
+  // Only the last fetch is visible once the block is done
+  if (last) {
+    out << "  c.opcode16 = " << Hex(opcode, 4) << ";\n";
+  }
+
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      if ((opcode & 0x000Fu) == 0x0) {
+        out << "  AotCore::Fallback(c, " << Hex(opcode, 4) << ");\n";
+      } else if ((opcode & 0x000Fu) == 0xE) {
+        out << "  --c.sp8;\n"
+            << "  c.pc16 = c.stack16_16[c.sp8 & STACK_MASK];\n"
+            << "  goto dispatch;\n";
+      }
+      break;
+
+    case 0x1: out << "  " << program.Goto(nnn) << "\n"; break;
+
+    case 0x2:
+      out << "  c.stack16_16[c.sp8 & STACK_MASK] = " << Hex(next, 3) << ";\n"
+          << "  ++c.sp8;\n"
+          << "  " << program.Goto(nnn) << "\n";
+      break;
+
+    case 0x3: Skip(vx + " == " + nn); break;
+    case 0x4: Skip(vx + " != " + nn); break;
+    case 0x5: Skip(vx + " == " + vy); break;
+    case 0x6: out << "  " << vx << " = " << nn << ";\n"; break;
+    case 0x7: out << "  " << vx << " += " << nn << ";\n"; break;
+
+    case 0x8:
+      switch (opcode & 0x000Fu) {
+        case 0x0: out << "  " << vx << " = " << vy << ";\n"; break;
+        case 0x1:
+        case 0x2:
+        case 0x3: {
+          char const* const assign[] = {"", " |= ", " &= ", " ^= "};
+          out << "  " << vx << assign[opcode & 0x000Fu] << vy << ";\n";
+
+          if (program.logic_resets_vf) {
+            out << "  " << vf << " = 0;\n";
+          }
+        } break;
+
+        case 0x4:
+          out << "  {\n"
+              << "    uint16_t sum = " << vx << " + " << vy << ";\n"
+              << "    " << vf << " = sum > 255u ? 1 : 0;\n"
+              << "    " << vx << " = sum & 0xFFu;\n"
+              << "  }\n";
+          break;
+
+        case 0x5:
+          out << "  " << vf << " = SubtractFlag(" << vx << ", " << vy
+              << ");\n"
+              << "  " << vx << " -= " << vy << ";\n";
+          break;
+
+        case 0x6:
+          if (program.shift_vy) {
+            out << "  " << vf << " = " << vy << " & 0x1u;\n"
+                << "  " << vx << " = " << vy << " >> 1u;\n";
+          } else {
+            out << "  " << vf << " = " << vx << " & 0x1u;\n"
+                << "  " << vx << " >>= 1;\n";
+          }
+          break;
+
+        case 0x7:
+          out << "  " << vf << " = SubtractFlag(" << vy << ", " << vx
+              << ");\n"
+              << "  " << vx << " = " << vy << " - " << vx << ";\n";
+          break;
+
+        case 0xE:
+          if (program.shift_vy) {
+            out << "  " << vf << " = (" << vy << " & 0x80u) >> 7u;\n"
+                << "  " << vx << " = " << vy << " << 1u;\n";
+          } else {
+            out << "  " << vf << " = (" << vx << " & 0x80u) >> 7u;\n"
+                << "  " << vx << " <<= 1;\n";
+          }
+          break;
+      }
+      break;
+
+    case 0x9: Skip(vx + " != " + vy); break;
+    case 0xA: out << "  c.index16 = " << Hex(nnn, 3) << ";\n"; break;
+
+    case 0xB:
+      out << "  c.pc16 = " << Hex(nnn, 3) << " + "
+          << V(program.jump_vx ? x : 0) << ";\n"
+          << "  goto dispatch;\n";
+      break;
+
+    case 0xC:
+    case 0xD:
+      out << "  AotCore::Fallback(c, " << Hex(opcode, 4) << ");\n";
+      break;
+
+    case 0xE:
+      if ((opcode & 0x000Fu) == 0xE) {
+        Skip("c.keypad8_16[" + vx + " & KEY_MASK]");
+      } else if ((opcode & 0x000Fu) == 0x1) {
+        Skip("!c.keypad8_16[" + vx + " & KEY_MASK]");
+      }
+      break;
+
+    case 0xF:
+      switch (opcode & 0x00FFu) {
+        case 0x07: out << "  " << vx << " = c.delay_timer8;\n"; break;
+
+        case 0x0A:
+          out << "  {\n"
+              << "    int key = FirstKeyDown(c.keypad8_16);\n"
+              << "    if (key < 0) { c.pc16 = " << Hex(address, 3)
+              << "; c.key_wait8 = 1; return budget; }  // halt\n"
+              << "    " << vx << " = static_cast<uint8_t>(key);\n"
+              << "  }\n"
+              << "  " << program.Goto(next) << "\n";
+          break;
+
+        case 0x15: out << "  c.delay_timer8 = " << vx << ";\n"; break;
+        case 0x18: out << "  c.sound_timer8 = " << vx << ";\n"; break;
+        case 0x1E: out << "  c.index16 += " << vx << ";\n"; break;
+
+        case 0x29:
+          out << "  c.index16 = " << Hex(FONTSET_START_ADDRESS, 2) << " + ("
+              << vx << " * 5);\n";
+          break;
+
+        case 0x33:
+        case 0x55:
+          out << "  core.Store(" << Hex(opcode, 4) << ");\n"
+              << "  " << program.Goto(next) << "\n";
+          break;
+
+        case 0x65:
+          out << "  for (uint8_t i = 0; i <= " << x << "; ++i) {\n"
+              << "    c.registers8_16[i] =\n"
+              << "        c.memory8_4kb[(c.index16 + i) & ADDRESS_MASK];\n"
+              << "  }\n";
+
+          if (program.load_store_increments_i) {
+            out << "  c.index16 += " << x + 1 << ";\n";
+          }
+          break;
+      }
+      break;
+  }
+}
+
+static void EmitBlock(Program const& program, AotBlock const& block,
+                      std::ostream& out) {
+  unsigned int count = (block.end - block.start) / 2;
+  std::string start = Hex(block.start, 3);
+
+  out << "\n"
+      << Label(block.start) << ":\n"
+      << "  if (budget < " << count << " || core.Stale(" << start
+      << ")) {\n"
+      << "    c.pc16 = " << start << ";\n"
+      << "    return budget;\n"
+      << "  }\n"
+      << "  budget -= " << count << ";\n";
+
+  unsigned int last = block.end - 2;
+
+  for (unsigned int address = block.start; address < block.end;
+       address += 2) {
+    EmitInstruction(program, address, address == last, out);
+  }
+
+  // Fell into the next block (skips/jumps/stores already left)
+  if (FlowOf(program.Opcode(last)) == FLOW_NEXT) {
+    out << "  " << program.Goto(block.end) << "\n";
+  }
+}
+
+bool RecompileRom(char const* rom_file, std::ostream& out) {
+  std::ifstream rom(rom_file, std::ios::binary);
+
+  if (!rom.is_open()) {
+    return false;
+  }
+
+  std::vector<uint8_t> image((std::istreambuf_iterator<char>(rom)),
+                             std::istreambuf_iterator<char>());
+
+  if (image.empty() || image.size() > MEMORY_SIZE - START_ADDRESS) {
+    return false;
+  }
+
+  Program program;
+  program.end = START_ADDRESS + image.size();
+  std::copy(image.begin(), image.end(), &program.memory[START_ADDRESS]);
+
+  // Dxyn/Fx55 go through Chip8's tables, which AotCore only runs this code
+  // with when they hold the same profile
+  program.quirks = QuirksForRom(rom_file);
+
+  WithQuirks(program.quirks, [&program](auto policy) {
+    typedef decltype(policy) Policy;
+
+    program.shift_vy = Policy::SHIFT_VY;
+    program.load_store_increments_i = Policy::LOAD_STORE_INCREMENTS_I;
+    program.jump_vx = Policy::JUMP_VX;
+    program.logic_resets_vf = Policy::LOGIC_RESETS_VF;
+  });
+
+  FindCode(program);
+  FindBlocks(program);
+
+  // ROM name for the registry, without its directory
+  std::string name = rom_file;
+  name = name.substr(name.find_last_of("/\\") + 1);
+
+  for (char& ch : name) {
+    ch = (ch == '"' || ch == '\\') ? '_' : ch;
+  }
+
+  char hash[32];
+  std::snprintf(hash, sizeof(hash), "0x%016llXull",
+                static_cast<unsigned long long>(
+                    HashRom(image.data(), image.size())));
+
+  out << "// Generated by `Chip8 --recompile` from " << name
+      << " (quirks: " << QuirkProfileName(program.quirks)
+      << ") -> do not edit\n"
+      << "\n"
+      << "#include \"aot_core.h\"\n"
+      << "\n"
+      << "namespace {\n"
+      << "\n"
+      << "uint32_t Run(AotCore& core, Chip8& c, uint32_t budget) {\n";
+
+  // Only 00EE/Bnnn jump back to the switch
+  for (AotBlock const& block : program.blocks) {
+    if (FlowOf(program.Opcode(block.end - 2)) == FLOW_DYNAMIC) {
+      out << "dispatch:\n";
+      break;
+    }
+  }
+
+  out << "  switch (c.pc16) {\n";
+
+  for (AotBlock const& block : program.blocks) {
+    out << "    case " << Hex(block.start, 3) << ": goto "
+        << Label(block.start) << ";\n";
+  }
+
+  out << "    default: return budget;  // not recompiled\n"
+      << "  }\n";
+
+  for (AotBlock const& block : program.blocks) {
+    EmitBlock(program, block, out);
+  }
+
+  out << "}\n"
+      << "\n"
+      << "const AotBlock blocks[] = {\n";
+
+  for (AotBlock const& block : program.blocks) {
+    out << "    {" << Hex(block.start, 3) << ", " << Hex(block.end, 3)
+        << "},\n";
+  }
+
+  out << "};\n"
+      << "\n"
+      << "const AotRegistrar registrar({\"" << name << "\", " << hash << ",\n"
+      << "                              " << image.size() << ", &Run, blocks,\n"
+      << "                              sizeof(blocks) / sizeof(blocks[0]),\n"
+      << "                              " << QuirkEnumerator(program.quirks)
+      << "});\n"
+      << "\n"
+      << "}  // namespace\n";
+
+  return true;
+}
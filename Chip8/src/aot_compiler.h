@@ -0,0 +1,18 @@
+#ifndef CHIP8_AOT_COMPILER_H
+
+#define CHIP8_AOT_COMPILER_H
+
+#include <ostream>
+
+const unsigned int AOT_MAX_BLOCK_INSTRUCTIONS = 64;
+
+// Static recompiler behind `Chip8 --recompile <ROM> <Out.cpp>`: disassembles
+// the ROM from START_ADDRESS, follows 1nnn/2nnn/Bnnn/skip targets to find the
+// reachable code and its basic blocks, and writes one C++ function that runs
+// them on a Chip8 (plus the AotRegistrar that hands it to AotCore). Build the
+// output into the emulator to get a native core for that ROM. The ROM's
+// quirk profile (its .quirks sidecar, see QuirksForRom) is compiled in.
+// Returns false if the ROM can't be read or doesn't fit in memory.
+bool RecompileRom(char const* rom_file, std::ostream& out);
+
+#endif  // CHIP8_AOT_COMPILER_H
@@ -0,0 +1,146 @@
+#include "aot_core.h"
+
+#include <vector>
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8::memory8_4kb);
+
+// Function-local -> safe to use from other files' static initializers
+static std::vector<AotProgram>& Programs() {
+  static std::vector<AotProgram> programs;
+  return programs;
+}
+
+void RegisterAotProgram(AotProgram const& program) {
+  Programs().push_back(program);
+}
+
+AotCore::AotCore(Chip8& chip8) : chip8(chip8) { Invalidate(); }
+
+void AotCore::Invalidate() {
+  program = nullptr;
+
+  for (AotProgram const& candidate : Programs()) {
+    if (candidate.size > MEMORY_SIZE - START_ADDRESS ||
+        candidate.quirks != chip8.Quirks()) {
+      continue;
+    }
+
+    uint64_t hash =
+        HashRom(&chip8.memory8_4kb[START_ADDRESS], candidate.size);
+
+    if (hash == candidate.hash) {
+      program = &candidate;
+      break;
+    }
+  }
+
+  for (unsigned int a = 0; a < MEMORY_SIZE; ++a) {
+    code_bytes[a] = false;
+    stale[a] = false;
+  }
+
+  if (program == nullptr) {
+    return;
+  }
+
+  for (unsigned int b = 0; b < program->block_count; ++b) {
+    for (unsigned int a = program->blocks[b].start; a < program->blocks[b].end;
+         ++a) {
+      code_bytes[a] = true;
+    }
+  }
+}
+
+unsigned int AotCore::StepFrame(unsigned int instructions) {
+  unsigned int ran = Run(instructions);
+  chip8.TickTimers();
+  return ran;
+}
+
+unsigned int AotCore::Run(unsigned int instructions) {
+  unsigned int due = instructions;
+
+  while (instructions > 0 && !chip8.Halted()) {
+    if (program != nullptr) {
+      uint32_t left = program->run(*this, chip8, instructions);
+
+      if (left < instructions) {
+        instructions = left;
+        continue;
+      }
+    }
+
+    // Unknown PC, stale block or not enough budget for the next block
+    InterpretOne();
+    --instructions;
+  }
+
+  return due - instructions;  // only a halt leaves some
+}
+
+void AotCore::InterpretOne() {
+  uint16_t index = chip8.index16;
+
+  chip8.Cycle();
+
+  uint16_t opcode = chip8.opcode16;
+
+  if ((opcode & 0xF0FFu) == 0xF033u) {
+    OnWrite(index, 3);
+  } else if ((opcode & 0xF0FFu) == 0xF055u) {
+    OnWrite(index, ((opcode & 0x0F00u) >> 8u) + 1u);
+  }
+}
+
+void AotCore::Fallback(Chip8& c, uint32_t opcode) {
+  c.opcode16 = static_cast<uint16_t>(opcode);
+  ((c).*(c.table[(opcode & 0xF000u) >> 12u]))();
+}
+
+void AotCore::Store(uint32_t opcode) {
+  uint16_t index = chip8.index16;
+
+  Fallback(chip8, opcode);
+
+  if ((opcode & 0x00FFu) == 0x33u) {
+    OnWrite(index, 3);
+  } else {
+    OnWrite(index, ((opcode & 0x0F00u) >> 8u) + 1u);
+  }
+}
+
+void AotCore::OnWrite(uint16_t address, unsigned int length) {
+  if (program == nullptr) {
+    return;
+  }
+
+  // Stores wrap at 4 KB -> the part past 0xFFF is a store at 0
+  address &= ADDRESS_MASK;
+
+  if (address + length > MEMORY_SIZE) {
+    unsigned int head = MEMORY_SIZE - address;
+
+    OnWrite(0, length - head);
+    length = head;
+  }
+
+  bool hits_code = false;
+
+  for (unsigned int a = address; a < address + length && a < MEMORY_SIZE;
+       ++a) {
+    hits_code = hits_code || code_bytes[a];
+  }
+
+  if (!hits_code) {
+    return;
+  }
+
+  // Stale blocks are interpreted from now on (until Invalidate())
+  for (unsigned int b = 0; b < program->block_count; ++b) {
+    AotBlock const& block = program->blocks[b];
+
+    if (block.end > address && block.start < address + length) {
+      stale[block.start] = true;
+    }
+  }
+}
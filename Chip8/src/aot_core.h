@@ -0,0 +1,79 @@
+#ifndef CHIP8_AOT_CORE_H
+
+#define CHIP8_AOT_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chip_8.h"
+#include "rom_cache.h"
+
+class AotCore;
+
+// One basic block of a recompiled ROM: bytes [start, end) of memory
+struct AotBlock {
+  uint16_t start;
+  uint16_t end;
+};
+
+// Generated code: runs blocks from chip8.pc16 until it reaches a PC it has
+// no code for, a stale block or one that doesn't fit; returns budget left
+typedef uint32_t (*AotFunc)(AotCore& core, Chip8& c, uint32_t budget);
+
+// What a file written by `Chip8 --recompile` registers at static init
+struct AotProgram {
+  char const* name;
+  uint64_t hash;  // HashRom() of the ROM image
+  uint32_t size;  // ROM bytes, loaded @START_ADDRESS
+  AotFunc run;
+  AotBlock const* blocks;
+  unsigned int block_count;
+  QuirkProfile quirks;  // compiled in; left out (older files) -> default
+};
+
+void RegisterAotProgram(AotProgram const& program);
+
+struct AotRegistrar {
+  explicit AotRegistrar(AotProgram const& program) {
+    RegisterAotProgram(program);
+  }
+};
+
+// Runs a Chip8 on the ahead-of-time recompiled code for its ROM, picked by
+// hashing the loaded image (and matching chip8.Quirks(), which the code
+// was recompiled for). PCs the recompiler couldn't resolve (computed
+// Bnnn targets, code outside the ROM) and blocks that Fx33/Fx55 have stored
+// into go through Chip8::Cycle() instead; so does every instruction when no
+// recompiled program matches. Same frame-step API as the other cores.
+class AotCore {
+ public:
+  explicit AotCore(Chip8& chip8);
+
+  bool Native() const { return program != nullptr; }  // found a program
+
+  // Same effect as N Cycle(); returns how many ran, as Chip8::StepFrame()
+  unsigned int Run(unsigned int instructions);
+  unsigned int StepFrame(unsigned int instructions);  // Chip8::StepFrame()
+
+  // Re-match the program after memory was written from outside (LoadRom, a
+  // restored snapshot...) or the quirk profile changed: blocks come back
+  // only if the image is intact
+  void Invalidate();
+
+  // Called from generated code
+  bool Stale(uint16_t start) const { return stale[start]; }
+  void Store(uint32_t opcode);                      // Fx33 / Fx55
+  static void Fallback(Chip8& c, uint32_t opcode);  // any Op_* via tables
+
+ private:
+  void InterpretOne();
+  void OnWrite(uint16_t address, unsigned int length);
+
+  Chip8& chip8;
+  AotProgram const* program{};
+
+  bool code_bytes[sizeof(Chip8::memory8_4kb)]{};  // read by some block
+  bool stale[sizeof(Chip8::memory8_4kb)]{};       // by block start
+};
+
+#endif  // CHIP8_AOT_CORE_H
@@ -0,0 +1,187 @@
+#include "audio.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cmath>
+
+void NullAudioSink::Write(int16_t const* data, unsigned int count) {
+  samples += count;
+
+  for (unsigned int i = 0; i < count; ++i) {
+    tone_samples += data[i] != 0;
+  }
+}
+
+unsigned int AudioRing::Size() const {
+  return head.load(std::memory_order_acquire) -
+         tail.load(std::memory_order_acquire);
+}
+
+unsigned int AudioRing::Push(int16_t const* samples, unsigned int count) {
+  uint32_t write = head.load(std::memory_order_relaxed);
+  uint32_t room =
+      AUDIO_RING_SAMPLES - (write - tail.load(std::memory_order_acquire));
+
+  count = std::min<unsigned int>(count, room);
+
+  for (unsigned int i = 0; i < count; ++i) {
+    ring[(write + i) & (AUDIO_RING_SAMPLES - 1)] = samples[i];
+  }
+
+  // Release -> the consumer sees the samples once it sees `head`
+  head.store(write + count, std::memory_order_release);
+  return count;
+}
+
+unsigned int AudioRing::Pop(int16_t* samples, unsigned int count) {
+  uint32_t read = tail.load(std::memory_order_relaxed);
+  uint32_t queued = head.load(std::memory_order_acquire) - read;
+
+  count = std::min<unsigned int>(count, queued);
+
+  for (unsigned int i = 0; i < count; ++i) {
+    samples[i] = ring[(read + i) & (AUDIO_RING_SAMPLES - 1)];
+  }
+
+  tail.store(read + count, std::memory_order_release);
+  return count;
+}
+
+SdlAudioSink::SdlAudioSink() {
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+    return;
+  }
+
+  SDL_AudioSpec want{};
+  want.freq = AUDIO_SAMPLE_RATE;
+  want.format = AUDIO_S16SYS;
+  want.channels = 1;
+  want.samples = AUDIO_DEVICE_SAMPLES;
+  want.callback = &SdlAudioSink::Callback;
+  want.userdata = this;
+
+  // Exact format or nothing: the synth only makes 48 kHz mono s16
+  SDL_AudioSpec have{};
+  device = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
+
+  if (device != 0) {
+    device_samples = have.samples;
+    SDL_PauseAudioDevice(device, 0);  // starts on silence until Write()
+  }
+}
+
+SdlAudioSink::~SdlAudioSink() {
+  if (device != 0) {
+    SDL_CloseAudioDevice(device);  // waits for a running callback
+  }
+}
+
+void SdlAudioSink::Write(int16_t const* samples, unsigned int count) {
+  unsigned int queued = ring.Size();
+
+  // Ran dry (or first frame) -> re-prime, so the callback doesn't run dry
+  // again on the very next frame's jitter
+  if (queued == 0) {
+    int16_t silence[AUDIO_CUSHION_SAMPLES]{};
+    queued = ring.Push(silence, AUDIO_CUSHION_SAMPLES);
+  }
+
+  // The callback may pop meanwhile -> a slight overestimate at most
+  ++writes;
+  queued_sum += queued;
+  max_queued = std::max(max_queued, queued);
+
+  // Cap what's queued -> latency stays bounded when the audio clock runs
+  // slower than the pacer
+  unsigned int cap =
+      AUDIO_SAMPLES_PER_FRAME + AUDIO_CUSHION_SAMPLES + AUDIO_SLACK_SAMPLES;
+  unsigned int room = queued < cap ? cap - queued : 0;
+  unsigned int pushed = ring.Push(samples, std::min(count, room));
+
+  dropped += count - pushed;
+}
+
+double SdlAudioSink::LatencyMs() const {
+  double queued = writes > 0 ? static_cast<double>(queued_sum) / writes : 0.0;
+  return (queued + device_samples) * 1000.0 / AUDIO_SAMPLE_RATE;
+}
+
+double SdlAudioSink::MaxLatencyMs() const {
+  return (max_queued + device_samples) * 1000.0 / AUDIO_SAMPLE_RATE;
+}
+
+void SdlAudioSink::Callback(void* self, uint8_t* stream, int bytes) {
+  SdlAudioSink& sink = *static_cast<SdlAudioSink*>(self);
+  int16_t* samples = reinterpret_cast<int16_t*>(stream);
+  unsigned int count = bytes / sizeof(int16_t);
+  unsigned int taken = sink.ring.Pop(samples, count);
+
+  // Short -> pad with silence; never wait for the emulation thread. Only
+  // the first short callback of a gap counts (and none before the start)
+  if (taken < count) {
+    std::fill(samples + taken, samples + count, int16_t{0});
+
+    if (sink.playing) {
+      sink.underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  sink.playing = taken == count;
+}
+
+void AudioSynth::SetPattern(uint8_t const* bytes, uint8_t pitch) {
+  use_pattern = bytes != nullptr;
+
+  if (use_pattern) {
+    std::copy(bytes, bytes + sizeof(pattern), pattern);
+    pattern_rate = PATTERN_BASE_RATE * std::pow(2.0, (pitch - 64) / 48.0);
+  }
+}
+
+void AudioSynth::Toggle(bool on, unsigned int offset) {
+  sounding = on;
+  toggles.push_back(static_cast<uint16_t>(offset));
+}
+
+void AudioSynth::EndFrame(bool on) {
+  bool tone = frame_start;
+  std::size_t next = 0;
+
+  double step = use_pattern ? pattern_rate / AUDIO_SAMPLE_RATE
+                            : double{TONE_HZ} / AUDIO_SAMPLE_RATE;
+
+  for (unsigned int s = 0; s < AUDIO_SAMPLES_PER_FRAME; ++s) {
+    // Toggles are in instruction order -> offsets never decrease
+    while (next < toggles.size() && toggles[next] <= s) {
+      tone = !tone;
+      ++next;
+    }
+
+    if (!tone) {
+      frame[s] = 0;
+      continue;
+    }
+
+    bool high;
+
+    if (use_pattern) {
+      unsigned int bit = static_cast<unsigned int>(phase) % PATTERN_BITS;
+      high = (pattern[bit / 8] >> (7 - bit % 8)) & 1u;
+    } else {
+      high = phase - std::floor(phase) < 0.5;
+    }
+
+    frame[s] = high ? TONE_AMPLITUDE : -TONE_AMPLITUDE;
+
+    // Keep the phase small -> no precision loss over long sessions
+    phase += step;
+    phase = std::fmod(phase, double{PATTERN_BITS});
+  }
+
+  sink.Write(frame, AUDIO_SAMPLES_PER_FRAME);
+
+  toggles.clear();
+  sounding = on;
+  frame_start = on;
+}
@@ -0,0 +1,158 @@
+#ifndef CHIP8_AUDIO_H
+
+#define CHIP8_AUDIO_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "chip_8.h"
+
+const unsigned int AUDIO_SAMPLE_RATE = 48000;  // mono, signed 16-bit
+const unsigned int AUDIO_SAMPLES_PER_FRAME =
+    AUDIO_SAMPLE_RATE / TIMER_HZ;              // 800 per 60 Hz frame
+const unsigned int AUDIO_DEVICE_SAMPLES = 256;   // per callback (5.3 ms)
+const unsigned int AUDIO_CUSHION_SAMPLES = 256;  // queued ahead (5.3 ms)
+const unsigned int AUDIO_SLACK_SAMPLES = 128;  // pacer/audio clock drift
+const unsigned int AUDIO_RING_SAMPLES = 4096;  // power of two
+const unsigned int TONE_HZ = 440;              // the CHIP-8 buzzer
+const int16_t TONE_AMPLITUDE = 3000;
+
+// XO-CHIP pattern playback rate: 4000 * 2^((pitch - 64) / 48) bits/s
+const double PATTERN_BASE_RATE = 4000.0;
+const unsigned int PATTERN_BITS = 128;  // 16 bytes, MSB first
+
+// Where synthesized samples go. Write() is called from the emulation
+// thread once per frame and must never block it
+class AudioSink {
+ public:
+  virtual ~AudioSink() = default;
+  virtual void Write(int16_t const* samples, unsigned int count) = 0;
+};
+
+// Plays nothing, counts everything -> headless runs and tests
+class NullAudioSink : public AudioSink {
+ public:
+  void Write(int16_t const* samples, unsigned int count) override;
+
+  uint64_t Samples() const { return samples; }
+  uint64_t ToneSamples() const { return tone_samples; }  // non-silent ones
+
+ private:
+  uint64_t samples{};
+  uint64_t tone_samples{};
+};
+
+// Single-producer/single-consumer sample queue without locks: the producer
+// only moves `head`, the consumer only `tail` (both count samples ever
+// queued/taken, so head - tail is the fill even after wrapping)
+class AudioRing {
+ public:
+  unsigned int Size() const;  // queued samples, from either side
+  unsigned int Push(int16_t const* samples, unsigned int count);  // queued
+  unsigned int Pop(int16_t* samples, unsigned int count);         // taken
+
+ private:
+  int16_t ring[AUDIO_RING_SAMPLES]{};
+  alignas(64) std::atomic<uint32_t> head{};
+  alignas(64) std::atomic<uint32_t> tail{};
+};
+
+// SDL playback. The device callback (SDL's audio thread) pops from an
+// AudioRing; Write() pushes without waiting. At most one frame plus
+// AUDIO_CUSHION_SAMPLES (+ drift slack) is ever queued, so a sample plays
+// about AUDIO_CUSHION_SAMPLES + AUDIO_DEVICE_SAMPLES after its frame was
+// emulated (10.7 ms); samples past that cap are dropped, and a queue that
+// ran dry is re-primed with the cushion in silence.
+class SdlAudioSink : public AudioSink {
+ public:
+  SdlAudioSink();
+  ~SdlAudioSink() override;
+
+  SdlAudioSink(SdlAudioSink const&) = delete;
+  SdlAudioSink& operator=(SdlAudioSink const&) = delete;
+
+  bool IsOpen() const { return device != 0; }  // false -> no audio device
+
+  void Write(int16_t const* samples, unsigned int count) override;
+
+  // Measured at each Write(): samples already queued ahead of the frame's
+  // first one, plus one device buffer
+  double LatencyMs() const;     // mean
+  double MaxLatencyMs() const;
+  uint64_t Underruns() const { return underruns.load(); }  // ran dry
+  uint64_t Dropped() const { return dropped; }  // samples over the cap
+
+ private:
+  static void Callback(void* self, uint8_t* stream, int bytes);
+
+  AudioRing ring;
+  uint32_t device{};
+  unsigned int device_samples{AUDIO_DEVICE_SAMPLES};  // what SDL granted
+  std::atomic<uint64_t> underruns{};
+  bool playing{};  // last callback was filled (callback thread only)
+  uint64_t dropped{};
+  uint64_t writes{};
+  uint64_t queued_sum{};  // ring.Size() at each Write(), re-prime included
+  unsigned int max_queued{};
+};
+
+// Turns the sound timer into samples, one emulated frame at a time: a tone
+// while it is non-zero, starting/stopping on the sample that matches the
+// instruction (or timer tick) that switched it. The XO-CHIP audio pattern
+// replaces the square wave when set.
+class AudioSynth {
+ public:
+  explicit AudioSynth(AudioSink& sink) : sink(sink) {}
+
+  // Sound state after `done` of this frame's `total` instructions
+  void Track(bool on, unsigned int done, unsigned int total) {
+    if (on != sounding) {
+      Toggle(on, done * AUDIO_SAMPLES_PER_FRAME / total);
+    }
+  }
+
+  // Play `pattern` (16 bytes) at `pitch` instead of the square wave, from
+  // the next frame on; nullptr -> square wave again
+  void SetPattern(uint8_t const* pattern, uint8_t pitch);
+
+  // Frame done (timers ticked): write its samples, `on` carries over
+  void EndFrame(bool on);
+
+ private:
+  void Toggle(bool on, unsigned int offset);
+
+  AudioSink& sink;
+
+  bool sounding{};     // tone state as of the last Track()
+  bool frame_start{};  // tone state at sample 0 of this frame
+  std::vector<uint16_t> toggles;  // sample offsets in this frame
+
+  double phase{};  // square wave: cycles, pattern: bits
+  bool use_pattern{};
+  uint8_t pattern[PATTERN_BITS / 8]{};
+  double pattern_rate{PATTERN_BASE_RATE};  // bits per second
+
+  int16_t frame[AUDIO_SAMPLES_PER_FRAME]{};
+};
+
+// One 60 Hz frame like Machine::StepFrame (Chip8 or ExtendedChip8), with
+// the sound timer followed instruction by instruction; returns the
+// instructions run, as StepFrame does
+template <typename Machine>
+unsigned int StepFrameWithAudio(Machine& machine, unsigned int instructions,
+                                AudioSynth& synth) {
+  unsigned int i = 0;
+
+  for (; i < instructions && !machine.Halted(); ++i) {
+    machine.Cycle();
+    i += machine.SkipIdle(instructions - i - 1);  // sound can't change there
+    synth.Track(machine.sound_timer8 != 0, i + 1, instructions);
+  }
+
+  machine.TickTimers();
+  synth.EndFrame(machine.sound_timer8 != 0);
+  return i;
+}
+
+#endif  // CHIP8_AUDIO_H
@@ -0,0 +1,698 @@
+#include "batch_core.h"
+
+#include <algorithm>
+#include <bitset>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define CHIP8_BATCH_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CHIP8_AVX2_TARGET  // MSVC takes AVX2 intrinsics anywhere
+#else
+#define CHIP8_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define CHIP8_BATCH_AVX2 0
+#endif
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8State::memory8_4kb);
+const unsigned int LANES = BATCH_BLOCK_LANES;
+const unsigned int LOCKSTEP_MISSES = 2;  // group searches per step that fail
+
+double BatchStats::LockstepShare() const {
+  uint64_t all = lockstep + scalar;
+  return all > 0 ? static_cast<double>(lockstep) / all : 0.0;
+}
+
+// Checked at run time -> the rest of the binary stays baseline x86-64
+static bool HasAvx2() {
+#if CHIP8_BATCH_AVX2 && defined(_MSC_VER) && !defined(__clang__)
+  int regs[4];
+  __cpuid(regs, 1);
+
+  // OS saves the YMM registers (OSXSAVE + XCR0 bits 1-2)
+  if ((regs[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+
+  __cpuidex(regs, 7, 0);
+  return (regs[1] & (1 << 5)) != 0;
+#elif CHIP8_BATCH_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+static unsigned int LowestLane(uint32_t lanes) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long lane;
+  _BitScanForward(&lane, lanes);
+  return lane;
+#else
+  return __builtin_ctz(lanes);
+#endif
+}
+
+// Same SplitMix64 step as Chip8::RandomByte()
+static uint8_t RandomByte(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+
+  return static_cast<uint8_t>((z ^ (z >> 31u)) >> 56u);
+}
+
+static void Gather(BatchCore::Block const& b, unsigned int l, Chip8State& s) {
+  for (unsigned int r = 0; r < 16; ++r) {
+    s.registers8_16[r] = b.v[r][l];
+    s.stack16_16[r] = b.stack[r][l];
+    s.keypad8_16[r] = b.keypad[r][l];
+  }
+
+  for (unsigned int a = 0; a < MEMORY_SIZE; ++a) {
+    s.memory8_4kb[a] = b.memory[a][l];
+  }
+
+  for (unsigned int y = 0; y < VIDEO_HEIGHT; ++y) {
+    s.video64_32[y] = b.video[y][l];
+  }
+
+  s.index16 = b.index[l];
+  s.pc16 = b.pc[l];
+  s.sp8 = b.sp[l];
+  s.delay_timer8 = b.delay[l];
+  s.sound_timer8 = b.sound[l];
+  s.key_wait8 = b.key_wait[l];
+  s.opcode16 = b.opcode[l];
+  s.random64 = b.random[l];
+}
+
+static void Scatter(BatchCore::Block& b, unsigned int l,
+                    Chip8State const& s) {
+  for (unsigned int r = 0; r < 16; ++r) {
+    b.v[r][l] = s.registers8_16[r];
+    b.stack[r][l] = s.stack16_16[r];
+    b.keypad[r][l] = s.keypad8_16[r];
+  }
+
+  for (unsigned int a = 0; a < MEMORY_SIZE; ++a) {
+    b.memory[a][l] = s.memory8_4kb[a];
+  }
+
+  for (unsigned int y = 0; y < VIDEO_HEIGHT; ++y) {
+    b.video[y][l] = s.video64_32[y];
+  }
+
+  b.index[l] = s.index16;
+  b.pc[l] = s.pc16;
+  b.sp[l] = s.sp8;
+  b.delay[l] = s.delay_timer8;
+  b.sound[l] = s.sound_timer8;
+  b.key_wait[l] = s.key_wait8;
+  b.opcode[l] = s.opcode16;
+  b.random[l] = s.random64;
+}
+
+#if CHIP8_BATCH_AVX2
+// Opcodes the shared step runs; the rest address memory, the stack, the
+// keypad or the RNG per lane. Same lookups as Chip8's tables
+static bool Lockstepped(uint16_t opcode) {
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      return (opcode & 0x000Fu) != 0x0 && (opcode & 0x000Fu) != 0xE;
+    case 0x2:
+    case 0xC:
+    case 0xD: return false;
+    case 0xE:
+      return (opcode & 0x000Fu) != 0x1 && (opcode & 0x000Fu) != 0xE;
+    case 0xF:
+      switch (opcode & 0x00FFu) {
+        case 0x0A:
+        case 0x33:
+        case 0x55:
+        case 0x65: return false;
+      }
+      return true;
+  }
+
+  return true;
+}
+
+// 32 lanes of bytes, or 2 x 16 lanes of words; `mask` bytes/words are
+// 0xFF.. for the lanes that take `value`
+
+CHIP8_AVX2_TARGET static inline __m256i Load(void const* p) {
+  return _mm256_load_si256(static_cast<__m256i const*>(p));
+}
+
+CHIP8_AVX2_TARGET static inline void Put(void* p, __m256i value,
+                                         __m256i mask) {
+  __m256i* to = static_cast<__m256i*>(p);
+  _mm256_store_si256(to, _mm256_blendv_epi8(_mm256_load_si256(to), value,
+                                            mask));
+}
+
+CHIP8_AVX2_TARGET static inline void Put16(uint16_t* p, __m256i lo,
+                                           __m256i hi, __m256i mask_lo,
+                                           __m256i mask_hi) {
+  Put(p, lo, mask_lo);
+  Put(p + 16, hi, mask_hi);
+}
+
+CHIP8_AVX2_TARGET static inline __m256i WidenLo(__m256i bytes) {
+  return _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes));
+}
+
+CHIP8_AVX2_TARGET static inline __m256i WidenHi(__m256i bytes) {
+  return _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1));
+}
+
+// Lanes (of `running`) at `leader`'s PC with its opcode there
+CHIP8_AVX2_TARGET static uint32_t SharedLanes(BatchCore::Block const& b,
+                                              unsigned int leader) {
+  uint16_t pc = b.pc[leader];
+  __m256i at_lo = _mm256_cmpeq_epi16(Load(b.pc), _mm256_set1_epi16(pc));
+  __m256i at_hi = _mm256_cmpeq_epi16(Load(b.pc + 16), _mm256_set1_epi16(pc));
+
+  // Words -> bytes in lane order (packs interleaves the 128-bit halves)
+  __m256i at = _mm256_permute4x64_epi64(_mm256_packs_epi16(at_lo, at_hi),
+                                        0xD8);
+
+  __m256i hi = _mm256_cmpeq_epi8(
+      Load(b.memory[pc]), _mm256_set1_epi8(static_cast<char>(
+                              b.memory[pc][leader])));
+  __m256i lo = _mm256_cmpeq_epi8(
+      Load(b.memory[pc + 1]), _mm256_set1_epi8(static_cast<char>(
+                                  b.memory[pc + 1][leader])));
+  __m256i running = _mm256_and_si256(
+      Load(b.live),
+      _mm256_cmpeq_epi8(Load(b.key_wait), _mm256_setzero_si256()));
+
+  __m256i shared =
+      _mm256_and_si256(_mm256_and_si256(at, running), _mm256_and_si256(hi, lo));
+
+  return static_cast<uint32_t>(_mm256_movemask_epi8(shared));
+}
+
+// One instruction for every lane in `lanes` (all at the same PC, same
+// opcode, which Lockstepped()); same effects as Chip8's handler per lane
+template <typename Policy>
+CHIP8_AVX2_TARGET static void LockstepCycle(BatchCore::Block& b,
+                                            uint32_t lanes, uint16_t pc,
+                                            uint16_t opcode) {
+  __m256i const zero = _mm256_setzero_si256();
+  __m256i const one = _mm256_set1_epi8(1);
+  __m256i const all = _mm256_set1_epi8(-1);
+
+  // Lane bit l -> byte l = 0xFF
+  __m256i select = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  __m256i spread = _mm256_shuffle_epi8(
+      _mm256_set1_epi32(static_cast<int>(lanes)),
+      _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                       2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3));
+  __m256i m = _mm256_cmpeq_epi8(_mm256_and_si256(spread, select), select);
+  __m256i m_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(m));
+  __m256i m_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(m, 1));
+
+  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t nn = opcode & 0x00FFu;
+  uint16_t nnn = opcode & 0x0FFFu;
+
+  __m256i const value = _mm256_set1_epi8(static_cast<char>(nn));
+
+  uint8_t* vx = b.v[x];
+  uint8_t* vy = b.v[y];
+  uint8_t* vf = b.v[0xF];
+
+  // Next PC: `target` (or per-lane `target_lo/hi`), +2 where `skip`
+  __m256i skip = zero;
+  __m256i target_lo = _mm256_set1_epi16(static_cast<short>(pc + 2));
+  __m256i target_hi = target_lo;
+
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x1:
+      target_lo = target_hi = _mm256_set1_epi16(static_cast<short>(nnn));
+      break;
+
+    case 0x3:
+      skip = _mm256_cmpeq_epi8(Load(vx), value);
+      break;
+
+    case 0x4:
+      skip = _mm256_xor_si256(_mm256_cmpeq_epi8(Load(vx), value), all);
+      break;
+
+    case 0x5: skip = _mm256_cmpeq_epi8(Load(vx), Load(vy)); break;
+
+    case 0x6: Put(vx, value, m); break;
+
+    case 0x7:
+      Put(vx, _mm256_add_epi8(Load(vx), value), m);
+      break;
+
+    case 0x8: {
+      // Flag first, then the result from re-read registers -> x or y == F
+      // come out as in Chip8's handlers
+      uint8_t* source = Policy::SHIFT_VY ? vy : vx;
+
+      switch (opcode & 0x000Fu) {
+        case 0x0: Put(vx, Load(vy), m); break;
+
+        case 0x1:
+        case 0x2:
+        case 0x3: {
+          __m256i a = Load(vx);
+          __m256i c = Load(vy);
+          __m256i r = (opcode & 0x000Fu) == 0x1   ? _mm256_or_si256(a, c)
+                      : (opcode & 0x000Fu) == 0x2 ? _mm256_and_si256(a, c)
+                                                  : _mm256_xor_si256(a, c);
+          Put(vx, r, m);
+
+          if (Policy::LOGIC_RESETS_VF) {
+            Put(vf, zero, m);
+          }
+          break;
+        }
+
+        case 0x4: {
+          __m256i a = Load(vx);
+          __m256i c = Load(vy);
+          __m256i sum = _mm256_add_epi8(a, c);
+
+          // Saturated == wrapped unless it carried
+          __m256i no_carry = _mm256_cmpeq_epi8(_mm256_adds_epu8(a, c), sum);
+          Put(vf, _mm256_andnot_si256(no_carry, one), m);
+          Put(vx, sum, m);
+          break;
+        }
+
+        case 0x5:
+        case 0x7: {
+          bool reverse = (opcode & 0x000Fu) == 0x7;  // Vy - Vx
+          __m256i a = Load(reverse ? vy : vx);
+          __m256i c = Load(reverse ? vx : vy);
+
+          // a > c <=> a -sat c != 0
+          __m256i not_gt =
+              _mm256_cmpeq_epi8(_mm256_subs_epu8(a, c), zero);
+          Put(vf, _mm256_andnot_si256(not_gt, one), m);
+
+          a = Load(reverse ? vy : vx);
+          c = Load(reverse ? vx : vy);
+          Put(vx, _mm256_sub_epi8(a, c), m);
+          break;
+        }
+
+        case 0x6:
+          Put(vf, _mm256_and_si256(Load(source), one), m);
+          Put(vx,
+              _mm256_and_si256(_mm256_srli_epi16(Load(source), 1),
+                               _mm256_set1_epi8(0x7F)),
+              m);
+          break;
+
+        case 0xE:
+          Put(vf,
+              _mm256_and_si256(_mm256_srli_epi16(Load(source), 7), one), m);
+          Put(vx, _mm256_add_epi8(Load(source), Load(source)), m);
+          break;
+      }
+      break;
+    }
+
+    case 0x9:
+      skip = _mm256_xor_si256(_mm256_cmpeq_epi8(Load(vx), Load(vy)), all);
+      break;
+
+    case 0xA:
+      Put16(b.index, _mm256_set1_epi16(static_cast<short>(nnn)),
+            _mm256_set1_epi16(static_cast<short>(nnn)), m_lo, m_hi);
+      break;
+
+    case 0xB: {
+      __m256i offset = Load(Policy::JUMP_VX ? vx : b.v[0]);
+      target_lo = _mm256_add_epi16(WidenLo(offset),
+                                   _mm256_set1_epi16(static_cast<short>(nnn)));
+      target_hi = _mm256_add_epi16(WidenHi(offset),
+                                   _mm256_set1_epi16(static_cast<short>(nnn)));
+      break;
+    }
+
+    case 0xF:
+      switch (nn) {
+        case 0x07: Put(vx, Load(b.delay), m); break;
+        case 0x15: Put(b.delay, Load(vx), m); break;
+        case 0x18: Put(b.sound, Load(vx), m); break;
+
+        case 0x1E:
+          Put16(b.index, _mm256_add_epi16(Load(b.index), WidenLo(Load(vx))),
+                _mm256_add_epi16(Load(b.index + 16), WidenHi(Load(vx))), m_lo,
+                m_hi);
+          break;
+
+        case 0x29: {
+          __m256i five = _mm256_set1_epi16(5);
+          __m256i font = _mm256_set1_epi16(FONTSET_START_ADDRESS);
+          Put16(b.index,
+                _mm256_add_epi16(font,
+                                 _mm256_mullo_epi16(WidenLo(Load(vx)), five)),
+                _mm256_add_epi16(font,
+                                 _mm256_mullo_epi16(WidenHi(Load(vx)), five)),
+                m_lo, m_hi);
+          break;
+        }
+      }
+      break;
+
+    // 0nnn/Exnn other than the per-lane ones: Op_NULL
+  }
+
+  __m256i two_lo = _mm256_and_si256(
+      _mm256_cvtepi8_epi16(_mm256_castsi256_si128(skip)), _mm256_set1_epi16(2));
+  __m256i two_hi = _mm256_and_si256(
+      _mm256_cvtepi8_epi16(_mm256_extracti128_si256(skip, 1)),
+      _mm256_set1_epi16(2));
+
+  Put16(b.pc, _mm256_add_epi16(target_lo, two_lo),
+        _mm256_add_epi16(target_hi, two_hi), m_lo, m_hi);
+  Put16(b.opcode, _mm256_set1_epi16(static_cast<short>(opcode)),
+        _mm256_set1_epi16(static_cast<short>(opcode)), m_lo, m_hi);
+}
+#endif
+
+BatchCore::BatchCore(Chip8 const& prototype, unsigned int lanes)
+    : lanes(lanes),
+      avx2(HasAvx2()),
+      blocks((lanes + LANES - 1) / LANES),
+      quirks(prototype.Quirks()) {
+
+  for (std::size_t b = 0; b < blocks.size(); ++b) {
+    for (unsigned int l = 0; l < LANES; ++l) {
+      Scatter(blocks[b], l, prototype);
+      blocks[b].live[l] = b * LANES + l < lanes ? 0xFF : 0;
+    }
+  }
+}
+
+void BatchCore::SetVectorized(bool enabled) { avx2 = enabled && HasAvx2(); }
+
+void BatchCore::Seed(unsigned int lane, uint64_t seed) {
+  blocks[lane / LANES].random[lane % LANES] = seed;
+}
+
+void BatchCore::SetKeys(unsigned int lane, uint8_t const* keypad) {
+  for (unsigned int key = 0; key < 16; ++key) {
+    blocks[lane / LANES].keypad[key][lane % LANES] = keypad[key];
+  }
+}
+
+void BatchCore::Save(unsigned int lane, Chip8State& state) const {
+  Gather(blocks[lane / LANES], lane % LANES, state);
+}
+
+void BatchCore::Load(unsigned int lane, Chip8State const& state) {
+  Scatter(blocks[lane / LANES], lane % LANES, state);
+}
+
+void BatchCore::StepFrame(unsigned int instructions) {
+  Run(instructions);
+
+  // Timers of every lane at once (padding lanes tick too, harmlessly)
+  for (Block& block : blocks) {
+    for (unsigned int l = 0; l < LANES; ++l) {
+      block.delay[l] -= block.delay[l] > 0;
+      block.sound[l] -= block.sound[l] > 0;
+    }
+  }
+}
+
+void BatchCore::Run(unsigned int instructions) {
+  // One switch per call -> lockstep and lane steps compiled per profile
+  WithQuirks(quirks, [this, instructions](auto policy) {
+    RunWith<decltype(policy)>(instructions);
+  });
+}
+
+template <typename Policy>
+void BatchCore::RunWith(unsigned int instructions) {
+  for (Block& block : blocks) {
+    uint32_t running = 0;
+
+    for (unsigned int l = 0; l < LANES; ++l) {
+      uint8_t keys[16];
+
+      for (unsigned int key = 0; key < 16; ++key) {
+        keys[key] = block.keypad[key][l];
+      }
+
+      // Halted in Fx0A -> resumes once a key is down (Chip8::Halted())
+      if (block.key_wait[l] != 0 && FirstKeyDown(keys) >= 0) {
+        block.key_wait[l] = 0;
+      }
+
+      if (block.live[l] != 0 && block.key_wait[l] == 0) {
+        running |= 1u << l;
+      }
+    }
+
+    for (unsigned int i = 0; i < instructions && running != 0; ++i) {
+      uint32_t shared = 0;
+
+#if CHIP8_BATCH_AVX2
+      if (avx2) {
+        // Group by group from the lowest lane; lanes left over once groups
+        // keep turning out single (or not lockstepped) run lane by lane
+        uint32_t candidates = running;
+
+        for (unsigned int misses = 0;
+             candidates != 0 && misses < LOCKSTEP_MISSES;) {
+          unsigned int leader = LowestLane(candidates);
+          uint16_t pc = block.pc[leader];
+          uint32_t group = 1u << leader;
+
+          if (pc < MEMORY_SIZE - 1) {
+            // Lanes already stepped this round may have landed here too
+            group = SharedLanes(block, leader) & candidates;
+          }
+
+          if ((group & (group - 1)) != 0 &&
+              Lockstepped((block.memory[pc][leader] << 8u) |
+                          block.memory[pc + 1][leader])) {
+            LockstepCycle<Policy>(block, group, pc,
+                                  (block.memory[pc][leader] << 8u) |
+                                      block.memory[pc + 1][leader]);
+            shared |= group;
+          } else {
+            ++misses;
+          }
+
+          candidates &= ~group;
+        }
+
+        stats.lockstep += std::bitset<32>(shared).count();
+      }
+#endif
+
+      for (uint32_t rest = running & ~shared; rest != 0; rest &= rest - 1) {
+        unsigned int lane = LowestLane(rest);
+
+        LaneCycle<Policy>(block, lane);
+        ++stats.scalar;
+
+        if (block.key_wait[lane] != 0) {
+          running &= ~(1u << lane);  // halted for the rest of this Run
+        }
+      }
+    }
+  }
+}
+
+template <typename Policy>
+void BatchCore::LaneCycle(Block& b, unsigned int l) {
+  uint16_t pc = b.pc[l];
+  uint16_t opcode = (b.memory[pc & ADDRESS_MASK][l] << 8u) |
+                    b.memory[(pc + 1) & ADDRESS_MASK][l];
+  uint8_t x = (opcode & 0x0F00u) >> 8u;
+  uint8_t y = (opcode & 0x00F0u) >> 4u;
+  uint8_t nn = opcode & 0x00FFu;
+  uint16_t nnn = opcode & 0x0FFFu;
+  uint16_t I = b.index[l];
+
+  auto V = [&b, l](unsigned int r) -> uint8_t& { return b.v[r][l]; };
+
+  b.opcode[l] = opcode;
+  pc += 2;
+
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      if ((opcode & 0x000Fu) == 0x0) {
+        for (unsigned int row = 0; row < VIDEO_HEIGHT; ++row) {
+          b.video[row][l] = 0;
+        }
+      } else if ((opcode & 0x000Fu) == 0xE) {
+        --b.sp[l];
+        pc = b.stack[b.sp[l] & STACK_MASK][l];
+      }
+      break;
+
+    case 0x1: pc = nnn; break;
+
+    case 0x2:
+      b.stack[b.sp[l] & STACK_MASK][l] = pc;
+      ++b.sp[l];
+      pc = nnn;
+      break;
+
+    case 0x3: pc += V(x) == nn ? 2 : 0; break;
+    case 0x4: pc += V(x) != nn ? 2 : 0; break;
+    case 0x5: pc += V(x) == V(y) ? 2 : 0; break;
+    case 0x6: V(x) = nn; break;
+    case 0x7: V(x) += nn; break;
+
+    case 0x8: {
+      unsigned int source = Policy::SHIFT_VY ? y : x;
+
+      switch (opcode & 0x000Fu) {
+        case 0x0: V(x) = V(y); break;
+        case 0x1:
+          V(x) |= V(y);
+          if (Policy::LOGIC_RESETS_VF) V(0xF) = 0;
+          break;
+        case 0x2:
+          V(x) &= V(y);
+          if (Policy::LOGIC_RESETS_VF) V(0xF) = 0;
+          break;
+        case 0x3:
+          V(x) ^= V(y);
+          if (Policy::LOGIC_RESETS_VF) V(0xF) = 0;
+          break;
+
+        case 0x4: {
+          unsigned int sum = V(x) + V(y);
+          V(0xF) = sum > 255u;
+          V(x) = sum & 0xFFu;
+          break;
+        }
+
+        case 0x5:
+          V(0xF) = V(x) > V(y);
+          V(x) -= V(y);
+          break;
+        case 0x6:
+          V(0xF) = V(source) & 0x1u;
+          V(x) = V(source) >> 1u;
+          break;
+        case 0x7:
+          V(0xF) = V(y) > V(x);
+          V(x) = V(y) - V(x);
+          break;
+        case 0xE:
+          V(0xF) = (V(source) & 0x80u) >> 7u;
+          V(x) = V(source) << 1u;
+          break;
+      }
+      break;
+    }
+
+    case 0x9: pc += V(x) != V(y) ? 2 : 0; break;
+    case 0xA: b.index[l] = nnn; break;
+    case 0xB: pc = nnn + V(Policy::JUMP_VX ? x : 0); break;
+    case 0xC: V(x) = RandomByte(b.random[l]) & nn; break;
+
+    case 0xD: {
+      // Same clipping/wrapping as Chip8::Op_Dxyn
+      uint8_t xPos = V(x) % VIDEO_WIDTH;
+      uint8_t yPos = V(y) % VIDEO_HEIGHT;
+      unsigned int height = opcode & 0x000Fu;
+      unsigned int rows = Policy::WRAP_SPRITES
+                              ? height
+                              : std::min<unsigned int>(height,
+                                                       VIDEO_HEIGHT - yPos);
+      uint64_t collision = 0;
+
+      for (unsigned int row = 0; row < rows; ++row) {
+        uint64_t bits = uint64_t{b.memory[(I + row) & ADDRESS_MASK][l]}
+                        << 56u;
+        uint64_t sprite = bits >> xPos;
+
+        if (Policy::WRAP_SPRITES && xPos != 0) {
+          sprite |= bits << (VIDEO_WIDTH - xPos);
+        }
+
+        uint64_t& display = b.video[(yPos + row) % VIDEO_HEIGHT][l];
+        collision |= display & sprite;
+        display ^= sprite;
+      }
+
+      V(0xF) = collision != 0 ? 1 : 0;
+      break;
+    }
+
+    case 0xE:
+      if ((opcode & 0x000Fu) == 0xE) {
+        pc += b.keypad[V(x) & KEY_MASK][l] ? 2 : 0;
+      } else if ((opcode & 0x000Fu) == 0x1) {
+        pc += b.keypad[V(x) & KEY_MASK][l] ? 0 : 2;
+      }
+      break;
+
+    case 0xF:
+      switch (nn) {
+        case 0x07: V(x) = b.delay[l]; break;
+
+        case 0x0A: {
+          uint8_t keys[16];
+
+          for (unsigned int key = 0; key < 16; ++key) {
+            keys[key] = b.keypad[key][l];
+          }
+
+          int key = FirstKeyDown(keys);
+
+          if (key >= 0) {
+            V(x) = static_cast<uint8_t>(key);
+          } else {
+            pc -= 2;  // halt on it, as Chip8::Op_Fx0A
+            b.key_wait[l] = 1;
+          }
+          break;
+        }
+
+        case 0x15: b.delay[l] = V(x); break;
+        case 0x18: b.sound[l] = V(x); break;
+        case 0x1E: b.index[l] = I + V(x); break;
+        case 0x29: b.index[l] = FONTSET_START_ADDRESS + V(x) * 5; break;
+
+        case 0x33:
+          b.memory[I & ADDRESS_MASK][l] = V(x) / 100;
+          b.memory[(I + 1) & ADDRESS_MASK][l] = V(x) / 10 % 10;
+          b.memory[(I + 2) & ADDRESS_MASK][l] = V(x) % 10;
+          break;
+
+        case 0x55:
+          for (unsigned int r = 0; r <= x; ++r) {
+            b.memory[(I + r) & ADDRESS_MASK][l] = V(r);
+          }
+          if (Policy::LOAD_STORE_INCREMENTS_I) b.index[l] = I + x + 1;
+          break;
+
+        case 0x65:
+          for (unsigned int r = 0; r <= x; ++r) {
+            V(r) = b.memory[(I + r) & ADDRESS_MASK][l];
+          }
+          if (Policy::LOAD_STORE_INCREMENTS_I) b.index[l] = I + x + 1;
+          break;
+      }
+      break;
+  }
+
+  b.pc[l] = pc;
+}
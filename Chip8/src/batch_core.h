@@ -0,0 +1,82 @@
+#ifndef CHIP8_BATCH_CORE_H
+
+#define CHIP8_BATCH_CORE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "chip_8.h"
+
+const unsigned int BATCH_BLOCK_LANES = 32;  // one AVX2 register of bytes
+
+struct BatchStats {
+  uint64_t lockstep{};  // lane-instructions run by the shared vector step
+  uint64_t scalar{};    // lane-instructions run one lane at a time
+
+  double LockstepShare() const;  // lockstep / all, 0..1
+};
+
+// Many copies of one machine (same ROM and quirk profile, own seeds and
+// keys) stepped in lockstep. Lanes live in blocks of BATCH_BLOCK_LANES in a
+// structure-of-arrays layout: V0 of 32 lanes side by side, then V1..., PC,
+// I, timers, the stack, and memory8_4kb as [address][lane].
+//
+// Each step, the lanes of a block that sit at the same PC with the same
+// opcode there run it together with AVX2 (ALU, skips, jumps, loads,
+// timers); the rest, and opcodes with per-lane addressing (draws, stores,
+// calls, Cxnn...), run lane by lane. Without AVX2 every lane runs lane by
+// lane. Either way every lane matches a Chip8 exactly, wrapping of
+// addresses, stack levels and keys included (ADDRESS_MASK, chip_8.h).
+class BatchCore {
+ public:
+  // `lanes` copies of `prototype` (ROM loaded, quirks set)
+  BatchCore(Chip8 const& prototype, unsigned int lanes);
+
+  unsigned int Lanes() const { return lanes; }
+  bool Vectorized() const { return avx2; }  // false -> lane by lane only
+  void SetVectorized(bool enabled);  // false -> lane by lane (tests)
+
+  void Seed(unsigned int lane, uint64_t seed);
+  void SetKeys(unsigned int lane, uint8_t const* keypad);  // 16 bytes
+
+  void Run(unsigned int instructions);  // every lane: N Chip8::Cycle()
+  void StepFrame(unsigned int instructions);  // every lane: Chip8::StepFrame
+
+  // Whole lane state in/out (snapshots, comparisons against a Chip8)
+  void Save(unsigned int lane, Chip8State& state) const;
+  void Load(unsigned int lane, Chip8State const& state);
+
+  BatchStats const& Stats() const { return stats; }
+
+  struct alignas(32) Block {
+    uint8_t v[16][BATCH_BLOCK_LANES];
+    uint16_t pc[BATCH_BLOCK_LANES];
+    uint16_t index[BATCH_BLOCK_LANES];
+    uint16_t opcode[BATCH_BLOCK_LANES];
+    uint8_t delay[BATCH_BLOCK_LANES];
+    uint8_t sound[BATCH_BLOCK_LANES];
+    uint8_t sp[BATCH_BLOCK_LANES];
+    uint8_t key_wait[BATCH_BLOCK_LANES];
+    uint8_t live[BATCH_BLOCK_LANES];  // 0xFF: a real lane (not padding)
+    uint8_t keypad[16][BATCH_BLOCK_LANES];
+    uint16_t stack[16][BATCH_BLOCK_LANES];
+    uint64_t random[BATCH_BLOCK_LANES];
+    uint64_t video[VIDEO_HEIGHT][BATCH_BLOCK_LANES];
+    uint8_t memory[sizeof(Chip8State::memory8_4kb)][BATCH_BLOCK_LANES];
+  };
+
+ private:
+  template <typename Policy>
+  void RunWith(unsigned int instructions);  // Run for one quirk profile
+
+  template <typename Policy>
+  void LaneCycle(Block& block, unsigned int lane);  // one lane, one Cycle()
+
+  unsigned int lanes;
+  bool avx2;
+  std::vector<Block> blocks;
+  QuirkProfile quirks;  // the prototype's
+  BatchStats stats;
+};
+
+#endif  // CHIP8_BATCH_CORE_H
@@ -0,0 +1,376 @@
+#include "bench.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "aot_core.h"
+#include "chip_8.h"
+#include "fleet.h"
+#include "jit_core.h"
+#include "predecoded_core.h"
+#include "rom_cache.h"
+
+const unsigned int BENCH_LOOP_INSTRUCTIONS = 64;  // body copies + jump back
+const uint64_t BENCH_SEED = 1;
+
+namespace {
+
+struct Workload {
+  std::string suite;
+  std::string name;
+  RomImage rom;  // ROM files: with their .quirks profile
+};
+
+struct Result {
+  Workload const* workload;
+  CoreKind core;
+  uint64_t instructions;  // executed, not the budget
+  double seconds;
+
+  double Mips() const {
+    return seconds > 0.0 ? instructions / seconds / 1e6 : 0.0;
+  }
+};
+
+// One Chip8 on any core, reset to `rom` (loaded as LoadRom does, quirk
+// profile included). `skip_idle` false -> idle loops run every pass, as on
+// the JIT and AOT cores
+class BenchMachine {
+ public:
+  BenchMachine(CoreKind core, RomImage const& rom, bool skip_idle)
+      : core(core) {
+    chip8.Seed(BENCH_SEED);
+    chip8.skip_idle = skip_idle;
+    chip8.LoadRom(rom);
+
+    switch (core) {
+      case CORE_TABLE: break;
+      case CORE_PREDECODED:
+        predecoded = std::make_unique<PredecodedCore>(chip8);
+        break;
+      case CORE_JIT: jit = std::make_unique<JitCore>(chip8); break;
+      case CORE_AOT: aot = std::make_unique<AotCore>(chip8); break;
+    }
+  }
+
+  // False if the core would only be the interpreter in disguise
+  bool Native() const {
+    switch (core) {
+      case CORE_JIT: return CHIP8_JIT_SUPPORTED != 0;
+      case CORE_AOT: return aot->Native();
+      default: return true;
+    }
+  }
+
+  uint8_t* Keypad() { return chip8.keypad8_16; }
+
+  // Instructions the frame ran (fewer than asked once halted in Fx0A)
+  unsigned int StepFrame(unsigned int instructions) {
+    switch (core) {
+      case CORE_TABLE: return chip8.StepFrame(instructions);
+      case CORE_PREDECODED: return predecoded->StepFrame(instructions);
+      case CORE_JIT: return jit->StepFrame(instructions);
+      case CORE_AOT: return aot->StepFrame(instructions);
+    }
+
+    return 0;
+  }
+
+ private:
+  CoreKind core;
+  Chip8 chip8;
+  std::unique_ptr<PredecodedCore> predecoded;
+  std::unique_ptr<JitCore> jit;
+  std::unique_ptr<AotCore> aot;
+};
+
+}  // namespace
+
+static void Put(std::vector<uint8_t>& rom, uint16_t opcode) {
+  rom.push_back(opcode >> 8u);
+  rom.push_back(opcode & 0xFFu);
+}
+
+// `setup` once, then as many whole copies of `body` as fit in
+// BENCH_LOOP_INSTRUCTIONS - 1 and a jump back -> nearly every instruction run
+// is from `body` (whole copies: a skip never lands past the jump)
+static std::vector<uint8_t> LoopRom(std::vector<uint16_t> const& setup,
+                                    std::vector<uint16_t> const& body) {
+  std::vector<uint8_t> rom;
+
+  for (uint16_t opcode : setup) {
+    Put(rom, opcode);
+  }
+
+  uint16_t loop = START_ADDRESS + rom.size();
+
+  std::size_t copies = (BENCH_LOOP_INSTRUCTIONS - 1) / body.size();
+
+  for (std::size_t i = 0; i < copies * body.size(); ++i) {
+    Put(rom, body[i % body.size()]);
+  }
+
+  Put(rom, 0x1000u | loop);
+  return rom;
+}
+
+// Every instruction a 1nnn to the next one (the last one closes the loop)
+static std::vector<uint8_t> JumpChainRom() {
+  std::vector<uint8_t> rom;
+
+  for (unsigned int i = 0; i + 1 < BENCH_LOOP_INSTRUCTIONS; ++i) {
+    Put(rom, 0x1000u | (START_ADDRESS + rom.size() + 2));
+  }
+
+  Put(rom, 0x1000u | START_ADDRESS);
+  return rom;
+}
+
+// 2nnn to a bare 00EE and back, forever
+static std::vector<uint8_t> CallReturnRom() {
+  std::vector<uint8_t> rom;
+
+  Put(rom, 0x2000u | (START_ADDRESS + 4));  // 0x200: CALL 0x204
+  Put(rom, 0x1000u | START_ADDRESS);        // 0x202: JP 0x200
+  Put(rom, 0x00EEu);                        // 0x204: RET
+
+  return rom;
+}
+
+static std::vector<Workload> MicroWorkloads() {
+  std::vector<Workload> workloads;
+
+  auto Add = [&](char const* suite, char const* name,
+                 std::vector<uint8_t> bytes) {
+    RomImage rom;  // synthetic -> QUIRKS_DEFAULT
+    rom.bytes = std::move(bytes);
+    workloads.push_back({suite, name, std::move(rom)});
+  };
+
+  // Per-instruction overhead: no real work behind the dispatch
+  Add("dispatch", "null_0nnn", LoopRom({}, {0x0001}));
+  Add("dispatch", "ld_6xnn", LoopRom({}, {0x6A12}));
+
+  Add("micro", "add_7xnn", LoopRom({}, {0x7A01}));
+  Add("micro", "alu_8xyn",
+      LoopRom({0x6105, 0x6203},
+              {0x8014, 0x8125, 0x8236, 0x8301, 0x8402, 0x8513, 0x8606,
+               0x870E, 0x8817}));
+  Add("micro", "skip_3xnn_not_taken", LoopRom({}, {0x3001}));
+  Add("micro", "skip_3xnn_taken", LoopRom({}, {0x3000, 0x6000}));
+  Add("micro", "jp_1nnn", JumpChainRom());
+  Add("micro", "call_ret", CallReturnRom());
+  Add("micro", "rnd_cxnn", LoopRom({}, {0xC0FF}));
+
+  // Font sprite 0 at x 58 -> half the drawn rows are clipped
+  Add("micro", "drw_n1", LoopRom({0xA050, 0x603A, 0x6100}, {0xD011}));
+  Add("micro", "drw_n5", LoopRom({0xA050, 0x603A, 0x6100}, {0xD015}));
+  Add("micro", "drw_n15", LoopRom({0xA050, 0x603A, 0x6100}, {0xD01F}));
+
+  Add("micro", "bcd_fx33", LoopRom({0xA300, 0x60FF}, {0xF033}));
+  Add("micro", "store_fx55", LoopRom({0xA300}, {0xFF55}));
+  Add("micro", "load_fx65", LoopRom({0xA300}, {0xFF65}));
+
+  return workloads;
+}
+
+static bool ReadRom(char const* file, RomImage& rom) {
+  std::shared_ptr<RomImage const> image = RomCache::Global().Load(file);
+
+  if (image == nullptr) {
+    std::cerr << "Cannot load ROM (missing or over " << MAX_ROM_SIZE
+              << " bytes): " << file << "\n";
+    return false;
+  }
+
+  rom = *image;
+  return true;
+}
+
+static std::string BaseName(char const* file) {
+  std::string name = file;
+  return name.substr(name.find_last_of("/\\") + 1);
+}
+
+// Best time of BENCH_REPEATS runs; `instructions` = what a run executed
+// (the same every repeat: fresh machine, keys up, fixed seed)
+static double TimeRun(CoreKind core, RomImage const& rom,
+                      uint64_t frames, bool& native, uint64_t& instructions) {
+  double best = 0.0;
+
+  for (unsigned int repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+    // Fresh machine each time -> every repeat does the same work
+    auto machine = std::make_unique<BenchMachine>(core, rom, false);
+    native = machine->Native();
+
+    if (!native) {
+      return 0.0;
+    }
+
+    uint64_t executed = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+      executed += machine->StepFrame(BENCH_INSTRUCTIONS_PER_FRAME);
+    }
+
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+
+    if (repeat == 0 || seconds.count() < best) {
+      best = seconds.count();
+    }
+
+    instructions = executed;
+  }
+
+  return best;
+}
+
+static void WriteJson(std::vector<Result> const& results,
+                      uint64_t instructions, std::ostream& out) {
+  out << "{\n"
+      << "  \"format\": " << BENCH_FORMAT_VERSION << ",\n"
+      << "  \"instructions_per_run\": " << instructions << ",\n"
+      << "  \"results\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    Result const& result = results[i];
+
+    // Table core of the same workload is always measured first. Rates,
+    // not times: a ROM that halts in Fx0A runs fewer than asked
+    double table_mips = result.Mips();
+
+    for (Result const& other : results) {
+      if (other.workload == result.workload && other.core == CORE_TABLE) {
+        table_mips = other.Mips();
+      }
+    }
+
+    double seconds = result.seconds > 0.0 ? result.seconds : 1e-12;
+    uint64_t instructions = result.instructions > 0 ? result.instructions : 1;
+
+    out << (i == 0 ? "\n" : ",\n") << "    {\"suite\": \""
+        << result.workload->suite << "\", \"name\": \""
+        << result.workload->name << "\", \"core\": \""
+        << CoreName(result.core)
+        << "\", \"instructions\": " << result.instructions
+        << ", \"seconds\": " << result.seconds
+        << ", \"mips\": " << result.Mips()
+        << ", \"ns_per_instruction\": " << seconds * 1e9 / instructions
+        << ", \"speedup_vs_table\": "
+        << (table_mips > 0.0 ? result.Mips() / table_mips : 0.0) << "}";
+  }
+
+  out << "\n  ]\n"
+      << "}\n";
+}
+
+bool RunBenchmarks(uint64_t instructions, std::vector<char const*> const& roms,
+                   std::ostream& out) {
+  std::vector<Workload> workloads = MicroWorkloads();
+
+  for (char const* file : roms) {
+    RomImage rom;
+
+    if (!ReadRom(file, rom)) {
+      return false;
+    }
+
+    // Name without the directory; keep it a plain JSON string
+    std::string name = BaseName(file);
+
+    for (char& ch : name) {
+      ch = (ch == '"' || ch == '\\') ? '_' : ch;
+    }
+
+    workloads.push_back({"macro", name, std::move(rom)});
+  }
+
+  uint64_t frames = instructions / BENCH_INSTRUCTIONS_PER_FRAME;
+  frames = frames > 0 ? frames : 1;
+
+  std::vector<Result> results;
+
+  for (Workload const& workload : workloads) {
+    for (CoreKind core : ALL_CORES) {
+      bool native = false;
+      uint64_t executed = 0;
+      double seconds = TimeRun(core, workload.rom, frames, native, executed);
+
+      if (!native) {
+        continue;  // e.g. aot for a ROM that wasn't recompiled in
+      }
+
+      Result result{&workload, core, executed, seconds};
+      results.push_back(result);
+
+      // Progress for humans; the JSON goes to `out` at the end
+      std::cerr << workload.suite << "/" << workload.name << " ["
+                << CoreName(core) << "]: " << result.Mips()
+                << " Minstr/s\n";
+    }
+  }
+
+  WriteJson(results, frames * BENCH_INSTRUCTIONS_PER_FRAME, out);
+  return true;
+}
+
+// Key (frame / TRAIN_KEY_FRAMES) % 16 down for all but the last 2 frames of
+// its slot -> every key gets pressed and released, same every run
+static void ScriptKeys(uint64_t frame, uint8_t* keypad) {
+  unsigned int key = (frame / TRAIN_KEY_FRAMES) % 16;
+  bool down = frame % TRAIN_KEY_FRAMES < TRAIN_KEY_FRAMES - 2;
+
+  for (unsigned int i = 0; i < 16; ++i) {
+    keypad[i] = (down && i == key) ? 1 : 0;
+  }
+}
+
+bool RunTraining(uint64_t frames, std::vector<char const*> const& roms,
+                 std::ostream& out) {
+  uint64_t total_instructions = 0;
+  double total_seconds = 0.0;
+
+  for (char const* file : roms) {
+    RomImage rom;
+
+    if (!ReadRom(file, rom)) {
+      return false;
+    }
+
+    // Every core, not just the table one -> the profile doesn't mark the
+    // others cold
+    for (CoreKind core : ALL_CORES) {
+      BenchMachine machine(core, rom, true);  // as played -> skipping too
+
+      if (!machine.Native()) {
+        continue;
+      }
+
+      uint64_t instructions = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      for (uint64_t frame = 0; frame < frames; ++frame) {
+        ScriptKeys(frame, machine.Keypad());
+        instructions += machine.StepFrame(BENCH_INSTRUCTIONS_PER_FRAME);
+      }
+
+      std::chrono::duration<double> seconds =
+          std::chrono::steady_clock::now() - start;
+
+      out << BaseName(file) << " [" << CoreName(core)
+          << "]: " << instructions / seconds.count() / 1e6 << " Minstr/s\n";
+
+      total_instructions += instructions;
+      total_seconds += seconds.count();
+    }
+  }
+
+  out << "total: "
+      << (total_seconds > 0.0 ? total_instructions / total_seconds / 1e6 : 0.0)
+      << " Minstr/s\n";
+  return true;
+}
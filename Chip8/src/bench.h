@@ -0,0 +1,43 @@
+#ifndef CHIP8_BENCH_H
+
+#define CHIP8_BENCH_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+const uint64_t BENCH_DEFAULT_INSTRUCTIONS = 20000000;  // per run
+const unsigned int BENCH_INSTRUCTIONS_PER_FRAME = 1000;
+const unsigned int BENCH_REPEATS = 3;  // best of -> less scheduler noise
+const uint32_t BENCH_FORMAT_VERSION = 1;
+const uint64_t TRAIN_DEFAULT_FRAMES = 20000;
+const unsigned int TRAIN_KEY_FRAMES = 8;  // each key: held 6, released 2
+
+// `Chip8 --bench`: times every available core on
+//   micro    - synthetic ROMs looping one opcode class (ALU, Dxyn heights,
+//              Fx33, Fx55/Fx65, jumps...)
+//   macro    - each ROM in `roms` under its .quirks profile, from reset,
+//              keys up, fixed RNG seed
+//   dispatch - a loop of the cheapest instruction -> pure dispatch cost
+// Idle loops run in full (Chip8::skip_idle off): JIT and AOT never skip,
+// so every core does the same work and the speedups compare like for like.
+// Every run is `instructions` long, or shorter if the ROM halts in Fx0A
+// (keys stay up); each result reports what it ran. Results go to `out` as
+// one JSON document (format BENCH_FORMAT_VERSION); each result carries its
+// speedup (in Minstr/s) over the table core so regressions show up as a
+// single number.
+// Returns false if a ROM can't be read.
+bool RunBenchmarks(uint64_t instructions, std::vector<char const*> const& roms,
+                   std::ostream& out);
+
+// `Chip8 --train`: the profile-guided build's training run (`make pgo`).
+// Runs each ROM in `roms` (under its .quirks profile) on every available
+// core for `frames` frames of BENCH_INSTRUCTIONS_PER_FRAME, fixed RNG seed,
+// with a scripted keypad that presses 0..F in turn -> menus get past
+// "press a key", games move.
+// Prints Minstr/s per ROM and core and a "total:" line to `out`.
+// Returns false if a ROM can't be read.
+bool RunTraining(uint64_t frames, std::vector<char const*> const& roms,
+                 std::ostream& out);
+
+#endif  // CHIP8_BENCH_H
@@ -1,12 +1,35 @@
 #include "chip_8.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
-#include <fstream>
-#include <random>
+#include <cstring>
+#include <memory>
 #include <string>
 
+#include "rom_cache.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHIP8_SSE2 1
+#else
+#define CHIP8_SSE2 0
+#endif
+
+#if CHIP8_STATS
+// Handlers count into this thread's scratch block, folded into the running
+// Chip8's `stats` by FlushStats() (every TickTimers). Counting into `stats`
+// directly costs 10-15% on tight ROM loops: `this` inside a handler comes
+// from the dispatch's member-pointer load, so the counter store's address
+// resolves late and the next fetch stalls behind it. A thread_local has a
+// fixed address -> ~free
+static thread_local ExecCounts scratch;
+#define CHIP8_COUNT(counter) (++scratch.counter)
+#else
+#define CHIP8_COUNT(counter) ((void)0)
+#endif
+
 uint8_t fontset[FONTSET_SIZE] = {
     // array [16 x 5B]
 
@@ -30,24 +53,26 @@ uint8_t fontset[FONTSET_SIZE] = {
 };
 
 // Modify default constructor
-Chip8::Chip8()
-    : RandomGen(std::chrono::system_clock::now().time_since_epoch().count())
-// Ctor membr initializtn list (direct initializtn)
-
-{
+Chip8::Chip8() {
   // Initialize pc
   pc16 = START_ADDRESS;
 
+  // Seed the random engine from the clock
+  random64 = std::chrono::system_clock::now().time_since_epoch().count();
+
   // Load fonts into mem
   for (unsigned int i = 0; i < FONTSET_SIZE; ++i) {
     memory8_4kb[FONTSET_START_ADDRESS + i] = fontset[i];
   }
 
-  // Give random num b/w 0 and 255
-  random_byte = std::uniform_int_distribution<unsigned short>(0, 255);
-
   // Fn Ptr table
 
+  // Brace init only sets slot 0 -> point every unused slot at Op_NULL
+  std::fill(std::begin(table0), std::end(table0), &Chip8::Op_NULL);
+  std::fill(std::begin(table8), std::end(table8), &Chip8::Op_NULL);
+  std::fill(std::begin(tableE), std::end(tableE), &Chip8::Op_NULL);
+  std::fill(std::begin(tableF), std::end(tableF), &Chip8::Op_NULL);
+
   // #
   table[0x0] = &Chip8::Table0;
   table[0x1] = &Chip8::Op_1nnn;
@@ -61,9 +86,7 @@ Chip8::Chip8()
   table[0x9] = &Chip8::Op_9xy0;
   // a
   table[0xA] = &Chip8::Op_Annn;
-  table[0xB] = &Chip8::Op_Bnnn;
   table[0xC] = &Chip8::Op_Cxnn;
-  table[0xD] = &Chip8::Op_Dxyn;
   table[0xE] = &Chip8::TableE;
   table[0xF] = &Chip8::TableF;
 
@@ -73,14 +96,9 @@ Chip8::Chip8()
 
   // 8
   table8[0x0] = &Chip8::Op_8xy0;
-  table8[0x1] = &Chip8::Op_8xy1;
-  table8[0x2] = &Chip8::Op_8xy2;
-  table8[0x3] = &Chip8::Op_8xy3;
   table8[0x4] = &Chip8::Op_8xy4;
   table8[0x5] = &Chip8::Op_8xy5;
-  table8[0x6] = &Chip8::Op_8xy6;
   table8[0x7] = &Chip8::Op_8xy7;
-  table8[0xE] = &Chip8::Op_8xyE;
 
   // E
   tableE[0x1] = &Chip8::Op_ExA1;
@@ -94,42 +112,67 @@ Chip8::Chip8()
   tableF[0x1E] = &Chip8::Op_Fx1E;
   tableF[0x29] = &Chip8::Op_Fx29;
   tableF[0x33] = &Chip8::Op_Fx33;
-  tableF[0x55] = &Chip8::Op_Fx55;
-  tableF[0x65] = &Chip8::Op_Fx65;
+
+  // Bnnn, Dxyn, 8xy1-3/6/E, Fx55/Fx65
+  SetQuirks(QUIRKS_DEFAULT);
 }
 
-void Chip8::LoadRom(char const* filename) {
-  // Open ROM as stream of bin, move file ptr to the end
-  std::ifstream rom(filename, std::ios::binary | std::ios::ate);
+void Chip8::SetQuirks(QuirkProfile profile) {
+  quirks = profile;
 
-  if (rom.is_open()) {
-    // Get ROM size -> allocate buffer to hold contents
-    std::streampos size = rom.tellg();
-    char* buffer = new char[size];
+  WithQuirks(profile, [this](auto policy) {
+    typedef decltype(policy) Policy;
 
-    // Go to beginning of the ROM -> fill the buffer by reading
-    rom.seekg(0, std::ios::beg);
-    rom.read(buffer, size);
-    rom.close();
+    table[0xB] = &Chip8::Op_Bnnn<Policy>;
+    table[0xD] = &Chip8::Op_Dxyn<Policy>;
 
-    // Load ROM contents into CHIP-8's memory (start @0x200):
-    for (long i = 0; i < size; ++i) {
-      memory8_4kb[START_ADDRESS + i] = buffer[i];
-    }
+    table8[0x1] = &Chip8::Op_8xy1<Policy>;
+    table8[0x2] = &Chip8::Op_8xy2<Policy>;
+    table8[0x3] = &Chip8::Op_8xy3<Policy>;
+    table8[0x6] = &Chip8::Op_8xy6<Policy>;
+    table8[0xE] = &Chip8::Op_8xyE<Policy>;
+
+    tableF[0x55] = &Chip8::Op_Fx55<Policy>;
+    tableF[0x65] = &Chip8::Op_Fx65<Policy>;
+  });
+}
+
+bool Chip8::LoadRom(char const* filename) {
+  std::shared_ptr<RomImage const> rom = RomCache::Global().Load(filename);
 
-    delete[] buffer;
+  if (rom == nullptr) {
+    return false;
   }
+
+  LoadRom(*rom);
+  return true;
+}
+
+void Chip8::LoadRom(RomImage const& rom) {
+  // Load ROM contents into CHIP-8's memory (start @0x200):
+  std::memcpy(&memory8_4kb[START_ADDRESS], rom.bytes.data(),
+              std::min<std::size_t>(rom.bytes.size(), MAX_ROM_SIZE));
+
+  SetQuirks(rom.quirks);
 }
 
 void Chip8::Cycle() {
   // Fetch operation
-  opcode16 = (memory8_4kb[pc16] << 8u) | memory8_4kb[pc16 + 1];
+  opcode16 = (memory8_4kb[pc16 & ADDRESS_MASK] << 8u) |
+             memory8_4kb[(pc16 + 1) & ADDRESS_MASK];
 
   // Increment before execn
   pc16 += 2;
 
   // Decode + Execute operations
   ((*this).*(table[(opcode16 & 0xF000u) >> 12u]))();
+}
+
+void Chip8::TickTimers() {
+#if CHIP8_STATS
+  FlushStats();
+  stats.EndFrame();
+#endif
 
   // Decrement delay timer if set
   if (delay_timer8 > 0) {
@@ -141,42 +184,198 @@ void Chip8::Cycle() {
   }
 }
 
-void Chip8::Table0() { ((*this).*(table0[opcode16 & 0x000Fu]))(); }
+unsigned int Chip8::StepFrame(unsigned int instructions) {
+  // Run the CPU in a batch -> timers see exactly one tick per frame. Halted
+  // -> the rest of the frame has nothing to run
+  unsigned int i = 0;
+
+  for (; i < instructions && !Halted(); ++i) {
+    Cycle();
+    i += SkipIdle(instructions - i - 1);
+  }
+
+  TickTimers();
+  return i;
+}
+
+unsigned int Chip8::IdleLoopLength(uint16_t target, uint16_t jump) const {
+  // One pass on a copy of the registers, same decoding as the tables; only
+  // Fx07/6xnn write and only skips/jumps steer
+  uint8_t v[16];
+  std::memcpy(v, registers8_16, sizeof(v));
+
+  uint16_t pc = target;
+
+  for (unsigned int length = 1; length <= IDLE_LOOP_MAX; ++length) {
+    if (pc >= sizeof(memory8_4kb) - 1) {
+      return 0;
+    }
+
+    uint16_t opcode = (memory8_4kb[pc] << 8u) | memory8_4kb[pc + 1];
+    uint8_t x = (opcode & 0x0F00u) >> 8u;
+    uint8_t y = (opcode & 0x00F0u) >> 4u;
+    bool skip = false;
+
+    pc += 2;
+
+    switch ((opcode & 0xF000u) >> 12u) {
+      case 0x1: pc = opcode & 0x0FFFu; break;
+      case 0x3: skip = v[x] == (opcode & 0x00FFu); break;
+      case 0x4: skip = v[x] != (opcode & 0x00FFu); break;
+      case 0x5: skip = v[x] == v[y]; break;
+      case 0x6: v[x] = opcode & 0x00FFu; break;
+      case 0x9: skip = v[x] != v[y]; break;
+
+      case 0xE:
+        if (v[x] > 0xF) {
+          return 0;  // key past the keypad -> not worth modelling
+        } else if ((opcode & 0x000Fu) == 0xE) {
+          skip = keypad8_16[v[x]] != 0;
+        } else if ((opcode & 0x000Fu) == 0x1) {
+          skip = keypad8_16[v[x]] == 0;
+        } else {
+          return 0;
+        }
+        break;
+
+      case 0xF:
+        if ((opcode & 0x00FFu) != 0x07) {
+          return 0;
+        }
+        v[x] = delay_timer8;
+        break;
+
+      default: return 0;
+    }
+
+    if (skip) {
+      pc += 2;
+    }
+
+    // Back at the start through the same jump, nothing changed -> a fixed
+    // point (opcode16 after any number of passes is `jump` again)
+    if (pc == target) {
+      return opcode == jump &&
+                     std::memcmp(v, registers8_16, sizeof(v)) == 0
+                 ? length
+                 : 0;
+    }
+  }
+
+  return 0;
+}
+
+unsigned int Chip8::SkipIdleLoop(unsigned int left) {
+  idle_probe = false;
+
+  unsigned int length = IdleLoopLength(pc16, opcode16);
+
+  if (length == 0) {
+    return 0;
+  }
+
+  // Whole passes only -> the rest runs normally and ends mid-loop as it
+  // would have
+  unsigned int skipped = left / length * length;
+  idle_skipped += skipped;
+#if CHIP8_STATS
+  scratch.idle_skipped += skipped;
+#endif
+  return skipped;
+}
+
+bool Chip8::Wake() {
+  if (FirstKeyDown(keypad8_16) < 0) {
+    return false;
+  }
+
+  key_wait8 = 0;
+  return true;
+}
+
+#if CHIP8_STATS
+void Chip8::FlushStats() {
+  stats.counts.Add(scratch);
+  scratch = ExecCounts{};
+}
+#endif
+
+void Chip8::LoadState(Chip8State const& state) {
+  static_cast<Chip8State&>(*this) = state;
+
+  dirty_rows32 = 0xFFFFFFFFu;  // display replaced -> redraw all of it
+}
+
+uint8_t Chip8::RandomByte() {
+  // SplitMix64: 8 bytes of state, so snapshots stay a plain copy
+  uint64_t z = (random64 += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+
+  return static_cast<uint8_t>((z ^ (z >> 31u)) >> 56u);
+}
 
-void Chip8::Table8() { ((*this).*(table8[opcode16 & 0x000Fu]))(); }
+void Chip8::Table0() {
+  CHIP8_COUNT(table0);
+  ((*this).*(table0[opcode16 & 0x000Fu]))();
+}
 
-void Chip8::TableE() { ((*this).*(tableE[opcode16 & 0x000Fu]))(); }
+void Chip8::Table8() {
+  CHIP8_COUNT(table8);
+  ((*this).*(table8[opcode16 & 0x000Fu]))();
+}
 
-void Chip8::TableF() { ((*this).*(tableF[opcode16 & 0x00FFu]))(); }
+void Chip8::TableE() {
+  CHIP8_COUNT(tableE);
+  ((*this).*(tableE[opcode16 & 0x000Fu]))();
+}
 
-void Chip8::Op_NULL() {}  // Do nothing
+void Chip8::TableF() {
+  CHIP8_COUNT(tableF);
+  ((*this).*(tableF[opcode16 & 0x00FFu]))();
+}
+
+void Chip8::Op_NULL() { CHIP8_COUNT(handlers[0]); }  // Do nothing
 
 void Chip8::Op_00E0() {  // 01) CLS
 
+  CHIP8_COUNT(handlers[1]);
+
   // Set entire video buffer to ZERO (black).
-  memset(video32_64_32, 0, sizeof(video32_64_32));
+  memset(video64_32, 0, sizeof(video64_32));
+  dirty_rows32 = 0xFFFFFFFFu;
 }
 
 void Chip8::Op_00EE() {  // 02) RET
 
+  CHIP8_COUNT(handlers[2]);
+
   // Decrement sp -> pc = address in stack
   --sp8;
-  pc16 = stack16_16[sp8];
+  pc16 = stack16_16[sp8 & STACK_MASK];
 }
 
 void Chip8::Op_1nnn() {  // 03) JMP
 
+  CHIP8_COUNT(handlers[3]);
+
   // opcode = 1nnn -> opcode AND 0fff ->  get `address` (nnn) -> pc = nnn
   uint16_t address = opcode16 & 0x0FFFu;
 
+  // Short backward jump -> maybe closes an idle loop (SkipIdle)
+  idle_probe = skip_idle && address <= pc16 - 2 &&
+               pc16 - 2u - address < IDLE_LOOP_SPAN;
+
   pc16 = address;
 }
 
 void Chip8::Op_2nnn() {  // 04) CALL
 
+  CHIP8_COUNT(handlers[4]);
+
   // store the addr pc is pointing to in stack -> ++sp ->
   // extract call addr from opcode (Op_1nnn) -> store in pc.
-  stack16_16[sp8] = pc16;
+  stack16_16[sp8 & STACK_MASK] = pc16;
   ++sp8;
 
   uint16_t address = opcode16 & 0x0FFFu;
@@ -185,6 +384,8 @@ void Chip8::Op_2nnn() {  // 04) CALL
 
 void Chip8::Op_3xnn() {  // 05) Skip next instruction if Vx = nn
 
+  CHIP8_COUNT(handlers[5]);
+
   uint8_t extract_nn = opcode16 & 0x00FFu;
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
@@ -195,6 +396,8 @@ void Chip8::Op_3xnn() {  // 05) Skip next instruction if Vx = nn
 
 void Chip8::Op_4xnn() {  // 06) Skip next instruction if Vx != nn
 
+  CHIP8_COUNT(handlers[6]);
+
   uint8_t extract_nn = opcode16 & 0x00FFu;
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
@@ -205,6 +408,8 @@ void Chip8::Op_4xnn() {  // 06) Skip next instruction if Vx != nn
 
 void Chip8::Op_5xy0() {  // 07) Skip next instruction if Vx = Vy
 
+  CHIP8_COUNT(handlers[7]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
@@ -215,6 +420,8 @@ void Chip8::Op_5xy0() {  // 07) Skip next instruction if Vx = Vy
 
 void Chip8::Op_6xnn() {  // 08) Set Vx = nn
 
+  CHIP8_COUNT(handlers[8]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t extract_nn = opcode16 & 0x00FF;
 
@@ -223,6 +430,8 @@ void Chip8::Op_6xnn() {  // 08) Set Vx = nn
 
 void Chip8::Op_7xnn() {  // 09) Set Vx = Vx + nn
 
+  CHIP8_COUNT(handlers[9]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t extract_nn = opcode16 & 0x00FFu;
 
@@ -231,39 +440,64 @@ void Chip8::Op_7xnn() {  // 09) Set Vx = Vx + nn
 
 void Chip8::Op_8xy0() {  // 10) Set Vx = Vy
 
+  CHIP8_COUNT(handlers[10]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
   registers8_16[v_x] = registers8_16[v_y];
 }
 
+template <typename Policy>
 void Chip8::Op_8xy1() {  // 11) Set Vx = Vx OR Vy
 
+  CHIP8_COUNT(handlers[11]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
   registers8_16[v_x] |= registers8_16[v_y];
+
+  if (Policy::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
 }
 
+template <typename Policy>
 void Chip8::Op_8xy2() {  // 12) Set Vx = Vx AND Vy
 
+  CHIP8_COUNT(handlers[12]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
   registers8_16[v_x] &= registers8_16[v_y];
+
+  if (Policy::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
 }
 
+template <typename Policy>
 void Chip8::Op_8xy3() {  // 13) Set Vx = Vx XOR Vy
 
+  CHIP8_COUNT(handlers[13]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
   registers8_16[v_x] ^= registers8_16[v_y];
+
+  if (Policy::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
 }
 
 void Chip8::Op_8xy4() {  // 14) Set Vx = Vx + Vy | Vf = 01 if Carry, else
                          // Vf = 00
 
+  CHIP8_COUNT(handlers[14]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
@@ -281,77 +515,69 @@ void Chip8::Op_8xy4() {  // 14) Set Vx = Vx + Vy | Vf = 01 if Carry, else
 void Chip8::Op_8xy5() {  // 15) Set Vx = Vx - Vy | Vf = 00 if borrow, else
                          // Vf = 01
 
+  CHIP8_COUNT(handlers[15]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
-  if (registers8_16[v_x] > registers8_16[v_y]) {
-    registers8_16[0xF] = 1;
-  } else {
-    registers8_16[0xF] = 0;
-  }
+  registers8_16[0xF] = SubtractFlag(registers8_16[v_x], registers8_16[v_y]);
 
   registers8_16[v_x] -= registers8_16[v_y];
 }
 
-void Chip8::Op_8xy6() {  // 16) Vy >> Vx | Shift Right Vy (1-bit) and store in
-                         // Vx | Don't modify Vy | Store Vy's LSB in Vf before
-                         // shifting | This differs from Cowgod & Austin Morlan
-
-  // uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
-  // uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+template <typename Policy>
+void Chip8::Op_8xy6() {  // 16) Set Vx = Vx >> 1 | Vf = LSB before shifting |
+                         // SHIFT_VY: Vx = Vy >> 1, Vy unmodified (COSMAC)
 
-  //// Store Vy's LSB in Vf
-  // registers8_16[0xF] = registers8_16[v_y] & 0x1;
+  CHIP8_COUNT(handlers[16]);
 
-  // registers8_16[v_x] = registers8_16[v_y] >> 1u;
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
-  // austin/cowgod:
-  uint8_t Vx = (opcode16 & 0x0F00u) >> 8u;
+  // austin/cowgod shift Vx in place
+  uint8_t source = Policy::SHIFT_VY ? v_y : v_x;
 
-  // Save LSB in VF
-  registers8_16[0xF] = (registers8_16[Vx] & 0x1u);
+  // Save LSB in VF (first -> x or y == F shifts the new VF)
+  registers8_16[0xF] = (registers8_16[source] & 0x1u);
 
-  registers8_16[Vx] >>= 1;
+  registers8_16[v_x] = registers8_16[source] >> 1u;
 }
 
 void Chip8::Op_8xy7() {  // 17) Set Vx = Vy - Vx | Vf = 00 if borrow, else
                          // Vf = 01
 
+  CHIP8_COUNT(handlers[17]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
-  if (registers8_16[v_y] > registers8_16[v_x]) {
-    registers8_16[0xF] = 1;
-  } else {
-    registers8_16[0xF] = 0;
-  }
+  registers8_16[0xF] = SubtractFlag(registers8_16[v_y], registers8_16[v_x]);
 
   registers8_16[v_x] = registers8_16[v_y] - registers8_16[v_x];
 }
 
-void Chip8::Op_8xyE() {  // 18) Vx << Vy | Shift Left Vy (1-bit) -> store in Vx
-                         // Don't modify Vy | Store Vy's MSB in Vf before
-                         // shifting | This differs from Cowgod & Austin Morlan
-
-  // uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
-  // uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+template <typename Policy>
+void Chip8::Op_8xyE() {  // 18) Set Vx = Vx << 1 | Vf = MSB before shifting |
+                         // SHIFT_VY: Vx = Vy << 1, Vy unmodified (COSMAC)
 
-  //// Store MSB in Vf
-  // registers8_16[0xF] = (registers8_16[v_y] & 0x80u) >> 7u;
+  CHIP8_COUNT(handlers[18]);
 
-  // registers8_16[v_x] = registers8_16[v_y] << 1u;
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
-  // austin/cowgod:
-  uint8_t Vx = (opcode16 & 0x0F00u) >> 8u;
+  // austin/cowgod shift Vx in place
+  uint8_t source = Policy::SHIFT_VY ? v_y : v_x;
 
-  // Save MSB in VF
-  registers8_16[0xF] = (registers8_16[Vx] & 0x80u) >> 7u;
+  // Save MSB in VF (first -> x or y == F shifts the new VF)
+  registers8_16[0xF] = (registers8_16[source] & 0x80u) >> 7u;
 
-  registers8_16[Vx] <<= 1;
+  registers8_16[v_x] = registers8_16[source] << 1u;
 }
 
 void Chip8::Op_9xy0() {  // 19) Skip next instruction if Vx != Vy
 
+  CHIP8_COUNT(handlers[19]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
 
@@ -362,81 +588,135 @@ void Chip8::Op_9xy0() {  // 19) Skip next instruction if Vx != Vy
 
 void Chip8::Op_Annn() {  // 20) Set index16 = nnn
 
+  CHIP8_COUNT(handlers[20]);
+
   uint16_t extract_nnn = (opcode16 & 0x0FFFu);
 
   index16 = extract_nnn;
 }
 
-void Chip8::Op_Bnnn() {  // 21) Jump to address (nnn + V0)
+template <typename Policy>
+void Chip8::Op_Bnnn() {  // 21) Jump to address (nnn + V0) | JUMP_VX: Bxnn ->
+                         // (xnn + Vx) (SUPER-CHIP)
+
+  CHIP8_COUNT(handlers[21]);
 
   uint16_t extract_nnn = (opcode16 & 0x0FFFu);
+  uint8_t v_x = Policy::JUMP_VX ? (opcode16 & 0x0F00u) >> 8u : 0;
 
-  pc16 = extract_nnn + registers8_16[0];
+  pc16 = extract_nnn + registers8_16[v_x];
 }
 
 void Chip8::Op_Cxnn() {  // 22) Set Vx = random number with mask of nn
 
+  CHIP8_COUNT(handlers[22]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t extract_nn = opcode16 & 0x00FFu;
 
   // Vx = RandomNum AND nn
-  registers8_16[v_x] = random_byte(RandomGen) & extract_nn;
+  registers8_16[v_x] = RandomByte() & extract_nn;
 }
 
+// XOR `rows` sprite rows onto consecutive display rows -> the display bits
+// turned off (any set -> collision)
+static uint64_t XorRows(uint64_t* display, uint64_t const* sprite,
+                        unsigned int rows) {
+  uint64_t collision = 0;
+  unsigned int row = 0;
+
+#if CHIP8_SSE2
+  // Two rows per step
+  __m128i collision2 = _mm_setzero_si128();
+
+  for (; row + 2 <= rows; row += 2) {
+    __m128i* pair = reinterpret_cast<__m128i*>(display + row);
+    __m128i pixels = _mm_loadu_si128(pair);
+    __m128i bits =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(sprite + row));
+
+    collision2 = _mm_or_si128(collision2, _mm_and_si128(pixels, bits));
+    _mm_storeu_si128(pair, _mm_xor_si128(pixels, bits));
+  }
+
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), collision2);
+  collision = lanes[0] | lanes[1];
+#endif
+
+  for (; row < rows; ++row) {
+    collision |= display[row] & sprite[row];
+    display[row] ^= sprite[row];
+  }
+
+  return collision;
+}
+
+template <typename Policy>
 void Chip8::Op_Dxyn() {  // 23) Draw sprite at (Vx, Vy) with n Bytes of sprite
                          // data starting at the address stored in `index16` |
                          // Set Vf = 01 if any set pixels are unset | Vf = 00
-                         // otherwise
+                         // otherwise | WRAP_SPRITES: wrap instead of clipping
+
+  CHIP8_COUNT(handlers[23]);
 
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
   uint8_t height_n = (opcode16 & 0x000Fu);  // height of sprite = n pixels
 
-  // Wrap (cut off) if sprite goes beyond screen bounds
+  // Start position wraps; the sprite itself is clipped at the right/bottom,
+  // or wraps around to the left/top with WRAP_SPRITES
   uint8_t xPos = registers8_16[v_x] % VIDEO_WIDTH;
   uint8_t yPos = registers8_16[v_y] % VIDEO_HEIGHT;
 
-  // Set Vf = 0
-  registers8_16[0xF] = 0;
+  unsigned int rows = Policy::WRAP_SPRITES
+                          ? height_n
+                          : std::min<unsigned int>(height_n,
+                                                   VIDEO_HEIGHT - yPos);
 
-  for (unsigned int row = 0; row < height_n; ++row) {  // For `n` pixel height
+  // Each sprite byte -> one display row: bit 7 lands on column xPos, bits
+  // shifted past column 63 fall off (clipping) or rotate round to column 0
+  uint64_t sprite[16];
 
-    // Each graphic will be `n` pixels high, and `n` is stored in `height_n`
-    uint8_t sprite_byte = memory8_4kb[index16 + row];  // sprite_byte = spB
+  for (unsigned int row = 0; row < rows; ++row) {
+    uint64_t bits =
+        uint64_t{memory8_4kb[(index16 + row) & ADDRESS_MASK]} << 56u;
 
-    for (unsigned int col = 0; col < 8; ++col) {  // For each pxl (bit) in spB
+    sprite[row] = bits >> xPos;
 
-      // Each graphic will be 8 pixels wide, that is why '8' is chosen
+    if (Policy::WRAP_SPRITES && xPos != 0) {
+      sprite[row] |= bits << (VIDEO_WIDTH - xPos);
+    }
 
-      // Extracting one sprite pixel (bit) from spB and determining if it is on
-      // or not, and then determining if display pixel is on or not, and whether
-      // to switch it on or off depending on the sprite pixel
-      uint8_t sprite_pixel = sprite_byte & (0x80u >> col);
-      uint32_t* display_pixel =
-          &video32_64_32[((yPos + row) * VIDEO_WIDTH) + (xPos + col)];
+    // A row only changes if some visible sprite bit is set
+    dirty_rows32 |= uint32_t{sprite[row] != 0}
+                    << ((yPos + row) % VIDEO_HEIGHT);
+  }
 
-      // sp is on (sp = 1)
-      if (sprite_pixel) {
-        // dp is also on (dp = 1), set Vf = 01
-        if (*display_pixel == 0xFFFFFFFF)  // it's uint32
-        {
-          registers8_16[0xF] = 1;
-        }
+  // Rows past the bottom (only with WRAP_SPRITES) continue from row 0
+  unsigned int below = std::min<unsigned int>(rows, VIDEO_HEIGHT - yPos);
 
-        // sp XOR dp (only done for sp = 1 case, since not required for sp = 0)
-        // dp ^= 0xFFFFFFFF because dp is 32 bits, and sp should also match that
-        *display_pixel ^= 0xFFFFFFFF;
-      }
-    }
+  uint64_t collision = XorRows(&video64_32[yPos], sprite, below);
+
+  if (Policy::WRAP_SPRITES && below < rows) {
+    collision |= XorRows(video64_32, sprite + below, rows - below);
+  }
+
+  registers8_16[0xF] = collision != 0 ? 1 : 0;
+
+  if (collision != 0) {
+    CHIP8_COUNT(collisions);
   }
 }
 
 void Chip8::Op_Ex9E() {  // 24) Skip next instruction if key with value in Vx is
                          // pressed
 
+  CHIP8_COUNT(handlers[24]);
+
   uint8_t v_x = (opcode16 & 0x0F00) >> 8u;
 
-  uint8_t key = registers8_16[v_x];
+  uint8_t key = registers8_16[v_x] & KEY_MASK;
 
   if (keypad8_16[key]) {
     pc16 += 2;
@@ -446,9 +726,11 @@ void Chip8::Op_Ex9E() {  // 24) Skip next instruction if key with value in Vx is
 void Chip8::Op_ExA1() {  // 25) Skip next instruction if key with value in Vx is
                          // ~pressed
 
+  CHIP8_COUNT(handlers[25]);
+
   uint8_t v_x = (opcode16 & 0x0F00) >> 8u;
 
-  uint8_t key = registers8_16[v_x];
+  uint8_t key = registers8_16[v_x] & KEY_MASK;
 
   if (!keypad8_16[key]) {
     pc16 += 2;
@@ -457,6 +739,8 @@ void Chip8::Op_ExA1() {  // 25) Skip next instruction if key with value in Vx is
 
 void Chip8::Op_Fx07() {  // 26) Set Vx = delay_timer8
 
+  CHIP8_COUNT(handlers[26]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
   registers8_16[v_x] = delay_timer8;
@@ -464,62 +748,27 @@ void Chip8::Op_Fx07() {  // 26) Set Vx = delay_timer8
 
 void Chip8::Op_Fx0A() {  // 27) Wait for key press, store key value in Vx
 
-  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
-
-  if (keypad8_16[0])
-    registers8_16[v_x] = 0;
-
-  else if (keypad8_16[1])
-    registers8_16[v_x] = 1;
-
-  else if (keypad8_16[2])
-    registers8_16[v_x] = 2;
-
-  else if (keypad8_16[3])
-    registers8_16[v_x] = 3;
-
-  else if (keypad8_16[4])
-    registers8_16[v_x] = 4;
-
-  else if (keypad8_16[5])
-    registers8_16[v_x] = 5;
-
-  else if (keypad8_16[6])
-    registers8_16[v_x] = 6;
-
-  else if (keypad8_16[7])
-    registers8_16[v_x] = 7;
-
-  else if (keypad8_16[8])
-    registers8_16[v_x] = 8;
+  CHIP8_COUNT(handlers[27]);
 
-  else if (keypad8_16[9])
-    registers8_16[v_x] = 9;
-
-  else if (keypad8_16[10])
-    registers8_16[v_x] = 10;
-
-  else if (keypad8_16[11])
-    registers8_16[v_x] = 11;
-
-  else if (keypad8_16[12])
-    registers8_16[v_x] = 12;
-
-  else if (keypad8_16[13])
-    registers8_16[v_x] = 13;
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
-  else if (keypad8_16[14])
-    registers8_16[v_x] = 14;
+  int key = FirstKeyDown(keypad8_16);
 
-  else if (keypad8_16[15])
-    registers8_16[v_x] = 15;
+  if (key >= 0) {
+    registers8_16[v_x] = static_cast<uint8_t>(key);
+    return;
+  }
 
-  else
-    pc16 -= 2;
+  // No key -> halt on this instruction; see Halted()
+  pc16 -= 2;
+  key_wait8 = 1;
+  CHIP8_COUNT(key_waits);
 }
 
 void Chip8::Op_Fx15() {  // 28) Set delay_timer8 = Vx
 
+  CHIP8_COUNT(handlers[28]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
   delay_timer8 = registers8_16[v_x];
@@ -527,6 +776,8 @@ void Chip8::Op_Fx15() {  // 28) Set delay_timer8 = Vx
 
 void Chip8::Op_Fx18() {  // 29) Set sound_timer8 = Vx
 
+  CHIP8_COUNT(handlers[29]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
   sound_timer8 = registers8_16[v_x];
@@ -534,6 +785,8 @@ void Chip8::Op_Fx18() {  // 29) Set sound_timer8 = Vx
 
 void Chip8::Op_Fx1E() {  // 30) Set index16 = Vx + index16
 
+  CHIP8_COUNT(handlers[30]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
   index16 += registers8_16[v_x];
@@ -542,6 +795,8 @@ void Chip8::Op_Fx1E() {  // 30) Set index16 = Vx + index16
 void Chip8::Op_Fx29() {  // 31) Set index16 = address of sprite => corresp. hex
                          // digit in Vx
 
+  CHIP8_COUNT(handlers[31]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t hex_digit_in_vx = registers8_16[v_x];  // get hex digit from Vx
 
@@ -552,52 +807,53 @@ void Chip8::Op_Fx33() {  // 32) Store Binary Coded Decimal equivalent of value
                          // in Vx @addresses `index16`, (`index16` + 1),
                          // (`index16` + 2)
 
+  CHIP8_COUNT(handlers[32]);
+
   uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
   uint8_t value_vx = registers8_16[v_x];
 
   for (int i = 0, j = 2; i < 3; i++, j--) {
     // Store 100s place in (idx), 10s place in (idx + 1), 1s place in (idx + 2)
-    memory8_4kb[index16 + j] = (value_vx / (int)std::pow(10, i)) % 10;
+    memory8_4kb[(index16 + j) & ADDRESS_MASK] =
+        (value_vx / (int)std::pow(10, i)) % 10;
   }
 }
 
+template <typename Policy>
 void Chip8::Op_Fx55() {  // 33) Store values of [V0 to Vx] in memory starting
-                         // @address `index16` | Set `index16` = `index16` + x +
-                         // 1 after storing | This differs from Cowgod & Austin
-
-  /*uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+                         // @address `index16` | LOAD_STORE_INCREMENTS_I: Set
+                         // `index16` = `index16` + x + 1 after storing
 
-  for (uint8_t i = 0; i < v_x + 1; i++) {
-    memory8_4kb[index16 + i] = registers8_16[i];
-  }
+  CHIP8_COUNT(handlers[33]);
 
-  index16 += v_x + 1;*/
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
-  // austin/cowgod:
-  uint8_t Vx = (opcode16 & 0x0F00u) >> 8u;
+  for (uint8_t i = 0; i <= v_x; ++i) {
+    memory8_4kb[(index16 + i) & ADDRESS_MASK] = registers8_16[i];
+  }
 
-  for (uint8_t i = 0; i <= Vx; ++i) {
-    memory8_4kb[index16 + i] = registers8_16[i];
+  // austin/cowgod leave index16 alone
+  if (Policy::LOAD_STORE_INCREMENTS_I) {
+    index16 += v_x + 1;
   }
 }
 
+template <typename Policy>
 void Chip8::Op_Fx65() {  // 34) Fill [V0 to Vx] with values in memory starting
-                         // @address `index16` | Set `index16` = `index16` + x +
-                         // 1 after filling | This differs from Cowgod & Austin
+                         // @address `index16` | LOAD_STORE_INCREMENTS_I: Set
+                         // `index16` = `index16` + x + 1 after filling
 
-  /*uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  CHIP8_COUNT(handlers[34]);
 
-  for (uint8_t i = 0; i < v_x + 1; i++) {
-    registers8_16[i] = memory8_4kb[index16 + i];
-  }
-
-  index16 += v_x + 1;*/
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
 
-  // austin/cowgod:
-  uint8_t Vx = (opcode16 & 0x0F00u) >> 8u;
+  for (uint8_t i = 0; i <= v_x; ++i) {
+    registers8_16[i] = memory8_4kb[(index16 + i) & ADDRESS_MASK];
+  }
 
-  for (uint8_t i = 0; i <= Vx; ++i) {
-    registers8_16[i] = memory8_4kb[index16 + i];
+  // austin/cowgod leave index16 alone
+  if (Policy::LOAD_STORE_INCREMENTS_I) {
+    index16 += v_x + 1;
   }
 }
 
@@ -3,16 +3,32 @@
 #define CHIP8_CHIP_8_H
 
 #include <cstdint>
-#include <random>
+#include <cstring>
+
+#include "quirks.h"
+#include "stats.h"
+
+struct RomImage;  // rom_cache.h
 
 const unsigned int VIDEO_HEIGHT = 32;
 const unsigned int VIDEO_WIDTH = 64;
 const unsigned int START_ADDRESS = 0x200;
+const unsigned int MAX_ROM_SIZE = 4096 - START_ADDRESS;  // 3584 B
+// Guest addresses are 12-bit: a fetch at PC or an access at I + n past
+// 0xFFF wraps to the start of memory; sp8 picks a stack level mod 16 and a
+// key number is taken mod 16 -> no ROM can reach past the arrays below
+const unsigned int ADDRESS_MASK = 0xFFF;
+const unsigned int STACK_MASK = 0xF;
+const unsigned int KEY_MASK = 0xF;
 const unsigned int FONTSET_SIZE = 80;  // 16 chars (0 to F), 5 Bytes each
 const unsigned int FONTSET_START_ADDRESS = 0x50;  // from reserved mem
+const unsigned int TIMER_HZ = 60;  // delay/sound timers tick at 60 Hz
+const unsigned int IDLE_LOOP_MAX = 8;  // longest polling loop recognised
+const unsigned int IDLE_LOOP_SPAN = 32;  // bytes (skipped instrucns too)
 
-class Chip8 {
- public:
+// Everything that affects execution, as one trivially copyable block:
+// a snapshot is a plain copy of it (see SaveState/LoadState, save_state.h)
+struct Chip8State {
   // variables - uniform initialization :: uint8, uint16 = chars
 
   uint8_t registers8_16[16]{};        // 8-bit (1 Byte) regs - 16
@@ -24,16 +40,114 @@ class Chip8 {
   uint8_t delay_timer8{};             // 8-bit delay timer
   uint8_t sound_timer8{};             // 8-bit sound timer
   uint8_t keypad8_16[16]{};           // 8-bit keys - 16 (0 to F)
-  uint32_t video32_64_32[64 * 32]{};  // 32-bit (64 x 32 - W x H) displ. mem
-  uint16_t opcode16;                  // 16-bit opc (e.g., 0x7522)
+  uint8_t key_wait8{};                // 1: halted in Fx0A (PC on it)
+  uint64_t video64_32[32]{};          // 1-bit displ. rows (MSB = x 0)
+  uint16_t opcode16{};                // 16-bit opc (e.g., 0x7522)
+  uint64_t random64{};                // Cxnn generator state (SplitMix64)
+};
+
+// VF after 8xy5/8xy7 (`minuend` - `subtrahend`): 1 only if `minuend` is
+// strictly greater, as in Cowgod's reference -> equal operands give 0 (the
+// original hardware's no-borrow rule would give 1). Every core and machine
+// follows it; the JIT and BatchCore emit the same comparison themselves
+inline uint8_t SubtractFlag(uint8_t minuend, uint8_t subtrahend) {
+  return minuend > subtrahend ? 1 : 0;
+}
+
+// Lowest key held in a 16-byte keypad, or -1 if none
+inline int FirstKeyDown(uint8_t const* keypad) {
+  uint64_t half[2];
+  std::memcpy(half, keypad, sizeof(half));
+
+  // Nothing held (the usual answer while waiting) -> two loads, one test
+  if ((half[0] | half[1]) == 0) {
+    return -1;
+  }
+
+  int key = 0;
+
+  while (!keypad[key]) {
+    ++key;
+  }
+
+  return key;
+}
+
+class Chip8 : public Chip8State {
+ public:
+  uint32_t dirty_rows32{};  // bit y: row y changed since present (not state)
+  uint64_t idle_skipped{};  // instructions skipped in idle loops (not state)
+  bool skip_idle{true};  // false -> run every pass (--bench: same work)
 
   // functions
   Chip8();  // default ctor
 
-  void LoadRom(char const* rom);  // load ROM instrucns to mem before executn
-  void Cycle();
+  // Load ROM instrucns to mem before executn. By path -> through
+  // RomCache::Global(), false if unreadable or over MAX_ROM_SIZE bytes
+  bool LoadRom(char const* rom);
+  void LoadRom(RomImage const& rom);  // bounded memcpy + its SetQuirks()
+  void Seed(uint64_t seed) { random64 = seed; }  // fix the Cxnn sequence
+  void Cycle();       // fetch + execute ONE instruction (timers untouched)
+  void TickTimers();  // one 60 Hz timer tick
+
+  // One 60 Hz frame: `instructions` Cycle() calls, then one TickTimers().
+  // Returns the instructions the frame ran, idle-skipped ones included:
+  // `instructions`, or fewer if it halted in Fx0A (see below)
+  unsigned int StepFrame(unsigned int instructions);
+
+  // Fx0A found no key down -> the CPU halts (PC stays on the Fx0A) until
+  // one is. While halted StepFrame() and every core's Run() return without
+  // fetching (or counting) anything and only the timers tick; a key down
+  // resumes, so the Fx0A runs once more and takes it. Cycle() alone just
+  // re-runs the Fx0A
+  bool Halted() { return key_wait8 != 0 && !Wake(); }
+
+  // Idle loops: polling the delay timer/keypad until it changes. Both only
+  // change between frames, so once a pass of the loop leaves everything as
+  // it found it, every later pass this frame is identical and can be
+  // skipped. Length in instructions of such a loop starting at `target`
+  // (closed by the jump `jump`, just run), walked against the current
+  // state; 0 = not one (writes anything but registers, exits, too long)
+  unsigned int IdleLoopLength(uint16_t target, uint16_t jump) const;
+
+  // Right after Cycle(): how many of the `left` instructions still due
+  // this frame are whole passes of an idle loop it just closed (added to
+  // idle_skipped; the caller just doesn't run them)
+  unsigned int SkipIdle(unsigned int left) {
+    return idle_probe ? SkipIdleLoop(left) : 0;
+  }
+
+  // Quirk profile the dispatch tables run (not state: a snapshot loads into
+  // whichever profile its ROM selected). Points the quirk-dependent slots at
+  // that profile's handler instantiations; like LoadRom, Invalidate() any
+  // core that caches code afterwards
+  QuirkProfile Quirks() const { return quirks; }
+  void SetQuirks(QuirkProfile profile);
+
+  // Copy the whole machine state out / in (a single memcpy each). After
+  // LoadState, Invalidate() any core that caches code from memory8_4kb
+  void SaveState(Chip8State& state) const { state = *this; }
+  void LoadState(Chip8State const& state);
+
+#if CHIP8_STATS
+  // Counts so far. Cycle() counts per thread; FlushStats() (also run by
+  // every TickTimers) moves this thread's counts since the last flush here
+  // -> flush before reading mid-frame, and don't interleave two Chip8s'
+  // frames on one thread
+  ExecStats stats;
+  void FlushStats();
+#endif
 
  private:
+  friend class PredecodedCore;  // run the same state with their own dispatch
+  friend class JitCore;
+  friend class AotCore;
+
+  bool Wake();  // clears the halt if a key is down
+  unsigned int SkipIdleLoop(unsigned int left);
+
+  bool idle_probe{};  // last Cycle() was a short backward jump
+
   void Table0();
   void Table8();
   void TableE();
@@ -57,13 +171,18 @@ class Chip8 {
 
   // 8
   void Op_8xy0();  // 10
+  template <typename Policy>
   void Op_8xy1();  // 11
+  template <typename Policy>
   void Op_8xy2();  // 12
+  template <typename Policy>
   void Op_8xy3();  // 13
   void Op_8xy4();  // 14
   void Op_8xy5();  // 15
+  template <typename Policy>
   void Op_8xy6();  // 16
   void Op_8xy7();  // 17
+  template <typename Policy>
   void Op_8xyE();  // 18
 
   // 9
@@ -71,8 +190,10 @@ class Chip8 {
 
   // a
   void Op_Annn();  // 20
+  template <typename Policy>
   void Op_Bnnn();  // 21
   void Op_Cxnn();  // 22
+  template <typename Policy>
   void Op_Dxyn();  // 23
 
   // E
@@ -87,24 +208,26 @@ class Chip8 {
   void Op_Fx1E();  // 30
   void Op_Fx29();  // 31
   void Op_Fx33();  // 32
+  template <typename Policy>
   void Op_Fx55();  // 33
+  template <typename Policy>
   void Op_Fx65();  // 34
 
-  std::mt19937 RandomGen;  // Random engine
+  uint8_t RandomByte();  // next byte from `random64`
 
-  // For a range of randnum - can only take in INT values, not BYTE
-  std::uniform_int_distribution<unsigned short> random_byte;
+  QuirkProfile quirks{QUIRKS_DEFAULT};
 
   // using (Chip8::*Chip8Func)() = void;  // Why can't I use this?
   // using Chip8Func = void;              // Should be used like this?
 
   typedef void (Chip8::*Chip8Func)();
 
+  // Sized for every value of the index nibble/byte; unused slots -> Op_NULL
   Chip8Func table[0xF + 1]{&Chip8::Op_NULL};
-  Chip8Func table0[0xE + 1]{&Chip8::Op_NULL};
-  Chip8Func table8[0xE + 1]{&Chip8::Op_NULL};
-  Chip8Func tableE[0xE + 1]{&Chip8::Op_NULL};
-  Chip8Func tableF[0x65 + 1]{&Chip8::Op_NULL};
+  Chip8Func table0[0xF + 1]{&Chip8::Op_NULL};
+  Chip8Func table8[0xF + 1]{&Chip8::Op_NULL};
+  Chip8Func tableE[0xF + 1]{&Chip8::Op_NULL};
+  Chip8Func tableF[0xFF + 1]{&Chip8::Op_NULL};
 };
 
 #endif  // CHIP8_CHIP_8_H
@@ -134,18 +257,18 @@ class Chip8 {
 
   // 8
   8xy0  10) Set Vx = Vy
-  8xy1  11) Set Vx = Vx OR  Vy
-  8xy2  12) Set Vx = Vx AND Vy
-  8xy3  13) Set Vx = Vx XOR Vy
+  8xy1  11) Set Vx = Vx OR  Vy  (LOGIC_RESETS_VF: then Vf = 00)
+  8xy2  12) Set Vx = Vx AND Vy  (LOGIC_RESETS_VF: then Vf = 00)
+  8xy3  13) Set Vx = Vx XOR Vy  (LOGIC_RESETS_VF: then Vf = 00)
   8xy4  14) Set Vx = Vx + Vy; Vf = 01 if Carry, else Vf = 00
   8xy5  15) Set Vx = Vx - Vy; Vf = 00 if borrow, else Vf = 01
-  8xy6  16) Vy >> Vx; Shift Right Vy (1-bit) and store in Vx;
-            Don't modify Vy; Store Vy's LSB in Vf before shifting
+  8xy6  16) Set Vx = Vx >> 1; Vf = Vx's LSB before shifting
+            (SHIFT_VY: Vx = Vy >> 1, Vf = Vy's LSB; Vy unmodified)
 
   8xy7  17) Set Vx = Vy - Vx; Vf = 00 if borrow, else Vf = 01
 
-  8xyE  18) Vx << Vy; Shift Left Vy (1-bit) and store in Vx; Don't
-            modify Vy; Store Vy's MSB in Vf before shifting
+  8xyE  18) Set Vx = Vx << 1; Vf = Vx's MSB before shifting
+            (SHIFT_VY: Vx = Vy << 1, Vf = Vy's MSB; Vy unmodified)
 
 
   // 9
@@ -154,11 +277,12 @@ class Chip8 {
 
   // a
   Annn  20) Set index16 = nnn (Instruction Register - IR)
-  Bnnn  21) Jump to address (nnn + V0)
+  Bnnn  21) Jump to address (nnn + V0)  (JUMP_VX: Bxnn -> xnn + Vx)
   Cxnn  22) Set Vx = random number with mask of nn
   Dxyn  23) Draw sprite at (Vx, Vy) with n Bytes of sprite data
             starting at the address stored in `index16`; Set Vf = 01
-            if any set pixels are unset; Vf = 00 otherwise
+            if any set pixels are unset; Vf = 00 otherwise; Clipped at
+            the right/bottom edges (WRAP_SPRITES: wrapped around them)
 
 
   // E
@@ -177,9 +301,9 @@ class Chip8 {
             @addresses `index16`, (`index16` + 1), (`index16` + 2)
 
   Fx55  33) Store values of [V0 to Vx] in memory starting @addr.
-            `index16`; Set `index16` = `index16` + x + 1 after storing
+            `index16` (LOAD_STORE_INCREMENTS_I: then `index16` += x + 1)
 
   Fx65  34) Fill [V0 to Vx] with values in memory starting @addr.
-            `index16`; Set `index16` = `index16` + x + 1 after filling
+            `index16` (LOAD_STORE_INCREMENTS_I: then `index16` += x + 1)
 
 */
\ No newline at end of file
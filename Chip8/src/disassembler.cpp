@@ -0,0 +1,72 @@
+#include "disassembler.h"
+
+#include <cstdio>
+
+std::string Disassemble(uint16_t opcode) {
+  unsigned int x = (opcode & 0x0F00u) >> 8u;
+  unsigned int y = (opcode & 0x00F0u) >> 4u;
+  unsigned int n = opcode & 0x000Fu;
+  unsigned int nn = opcode & 0x00FFu;
+  unsigned int nnn = opcode & 0x0FFFu;
+
+  char text[32];
+  std::snprintf(text, sizeof(text), "DW 0x%04X", opcode);  // Op_NULL
+
+  auto Print = [&](char const* format, unsigned int a, unsigned int b = 0,
+                   unsigned int c = 0) {
+    std::snprintf(text, sizeof(text), format, a, b, c);
+  };
+
+  // Binary ALU ops, indexed by the low nibble of 8xyn
+  static char const* const ALU[0xF + 1] = {
+      "LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN",
+      nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "SHL", nullptr};
+
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      if (n == 0x0) return "CLS";
+      if (n == 0xE) return "RET";
+      break;
+
+    case 0x1: Print("JMP 0x%03X", nnn); break;
+    case 0x2: Print("CALL 0x%03X", nnn); break;
+    case 0x3: Print("SE V%X, 0x%02X", x, nn); break;
+    case 0x4: Print("SNE V%X, 0x%02X", x, nn); break;
+    case 0x5: Print("SE V%X, V%X", x, y); break;
+    case 0x6: Print("LD V%X, 0x%02X", x, nn); break;
+    case 0x7: Print("ADD V%X, 0x%02X", x, nn); break;
+
+    case 0x8:
+      if (ALU[n] != nullptr) {
+        std::snprintf(text, sizeof(text), "%s V%X, V%X", ALU[n], x, y);
+      }
+      break;
+
+    case 0x9: Print("SNE V%X, V%X", x, y); break;
+    case 0xA: Print("LD I, 0x%03X", nnn); break;
+    case 0xB: Print("JMP V0, 0x%03X", nnn); break;
+    case 0xC: Print("RND V%X, 0x%02X", x, nn); break;
+    case 0xD: Print("DRW V%X, V%X, %u", x, y, n); break;
+
+    case 0xE:
+      if (n == 0xE) Print("SKP V%X", x);
+      if (n == 0x1) Print("SKNP V%X", x);
+      break;
+
+    case 0xF:
+      switch (nn) {
+        case 0x07: Print("LD V%X, DT", x); break;
+        case 0x0A: Print("LD V%X, K", x); break;
+        case 0x15: Print("LD DT, V%X", x); break;
+        case 0x18: Print("LD ST, V%X", x); break;
+        case 0x1E: Print("ADD I, V%X", x); break;
+        case 0x29: Print("LD F, V%X", x); break;
+        case 0x33: Print("LD B, V%X", x); break;
+        case 0x55: Print("LD [I], V%X", x); break;
+        case 0x65: Print("LD V%X, [I]", x); break;
+      }
+      break;
+  }
+
+  return text;
+}
@@ -0,0 +1,14 @@
+#ifndef CHIP8_DISASSEMBLER_H
+
+#define CHIP8_DISASSEMBLER_H
+
+#include <cstdint>
+#include <string>
+
+// One instruction as Chip8's tables would run it, Cowgod-style mnemonics
+// with the names of the reference in chip_8.h (e.g. "DRW V0, V1, 5",
+// "LD I, 0x2EA"). Sub-tables only look at the low nibble/byte, so e.g.
+// 0x0230 reads as CLS; anything that lands on Op_NULL is "DW 0xXXXX"
+std::string Disassemble(uint16_t opcode);
+
+#endif  // CHIP8_DISASSEMBLER_H
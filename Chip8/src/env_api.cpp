@@ -0,0 +1,297 @@
+#include "env_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chip_8.h"
+#include "rom_cache.h"
+
+// Idle worker: yields this many times for the next step before sleeping
+// (training loops call step back to back)
+const unsigned int ENV_SPIN_YIELDS = 2000;
+
+struct EnvHook {
+  int source;
+  uint32_t address;
+  float scale;    // reward hooks
+  uint8_t value;  // done hooks
+};
+
+struct Chip8Env {
+  Chip8Env(Chip8 const& prototype, uint32_t envs, uint32_t frames,
+           uint32_t instructions, unsigned int threads);
+  ~Chip8Env();
+
+  uint8_t Read(Chip8 const& machine, EnvHook const& hook) const;
+  void Restart(uint32_t i);  // back to the loaded ROM, hook baselines too
+  void StepRange(unsigned int worker);
+  void Worker(unsigned int worker);
+
+  // Contiguous -> one stride between every env's video64_32
+  std::vector<Chip8> machines;
+  Chip8State start;  // right after LoadRom
+
+  uint32_t frames_per_step;
+  uint32_t instructions_per_frame;
+
+  std::vector<EnvHook> rewards_from;
+  std::vector<EnvHook> dones_from;
+  std::vector<uint8_t> baseline;  // [env][reward hook]: value before step
+
+  std::vector<float> rewards;
+  std::vector<uint8_t> dones;
+
+  // Pool: worker w (0 = the calling thread) steps envs [w * N / T, ...)
+  unsigned int thread_count;
+  std::vector<std::thread> workers;
+  int32_t const* actions{};
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  std::atomic<uint64_t> generation{};  // bumped per step
+  std::atomic<unsigned int> finished{};  // helper workers done this step
+  bool stopping{};
+};
+
+Chip8Env::Chip8Env(Chip8 const& prototype, uint32_t envs, uint32_t frames,
+                   uint32_t instructions, unsigned int threads)
+    : machines(envs, prototype),
+      frames_per_step(frames),
+      instructions_per_frame(instructions),
+      rewards(envs),
+      dones(envs),
+      thread_count(std::min<unsigned int>(threads, envs)) {
+  prototype.SaveState(start);
+
+  for (unsigned int w = 1; w < thread_count; ++w) {
+    workers.emplace_back(&Chip8Env::Worker, this, w);
+  }
+}
+
+Chip8Env::~Chip8Env() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    stopping = true;
+    generation.fetch_add(1, std::memory_order_release);
+  }
+
+  wake.notify_all();
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+uint8_t Chip8Env::Read(Chip8 const& machine, EnvHook const& hook) const {
+  return hook.source == CHIP8_ENV_REGISTER
+             ? machine.registers8_16[hook.address]
+             : machine.memory8_4kb[hook.address];
+}
+
+void Chip8Env::Restart(uint32_t i) {
+  Chip8& machine = machines[i];
+  uint64_t random = machine.random64;
+
+  machine.LoadState(start);
+  machine.random64 = random;
+
+  for (std::size_t h = 0; h < rewards_from.size(); ++h) {
+    baseline[i * rewards_from.size() + h] = Read(machine, rewards_from[h]);
+  }
+}
+
+void Chip8Env::StepRange(unsigned int worker) {
+  std::size_t envs = machines.size();
+  std::size_t first = envs * worker / thread_count;
+  std::size_t last = envs * (worker + 1) / thread_count;
+  std::size_t hooks = rewards_from.size();
+
+  for (std::size_t i = first; i < last; ++i) {
+    Chip8& machine = machines[i];
+
+    std::memset(machine.keypad8_16, 0, sizeof(machine.keypad8_16));
+
+    if (actions[i] >= 0 && actions[i] <= 0xF) {
+      machine.keypad8_16[actions[i]] = 1;
+    }
+
+    for (uint32_t frame = 0; frame < frames_per_step; ++frame) {
+      machine.StepFrame(instructions_per_frame);
+    }
+
+    float reward = 0.0f;
+
+    for (std::size_t h = 0; h < hooks; ++h) {
+      uint8_t value = Read(machine, rewards_from[h]);
+      uint8_t& before = baseline[i * hooks + h];
+
+      reward += rewards_from[h].scale * (int{value} - int{before});
+      before = value;
+    }
+
+    bool done = false;
+
+    for (EnvHook const& hook : dones_from) {
+      done |= Read(machine, hook) == hook.value;
+    }
+
+    rewards[i] = reward;
+    dones[i] = done;
+
+    // Observation after a done is the next episode's first frame
+    if (done) {
+      Restart(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+void Chip8Env::Worker(unsigned int worker) {
+  uint64_t seen = 0;
+
+  for (;;) {
+    for (unsigned int spin = 0;
+         spin < ENV_SPIN_YIELDS &&
+         generation.load(std::memory_order_acquire) == seen;
+         ++spin) {
+      std::this_thread::yield();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      wake.wait(lock, [this, seen] {
+        return generation.load(std::memory_order_acquire) != seen;
+      });
+
+      seen = generation.load(std::memory_order_acquire);
+
+      if (stopping) {
+        return;
+      }
+    }
+
+    StepRange(worker);
+    finished.fetch_add(1, std::memory_order_release);
+  }
+}
+
+static bool ValidHook(int source, uint32_t address) {
+  return (source == CHIP8_ENV_REGISTER && address <= 0xF) ||
+         (source == CHIP8_ENV_MEMORY &&
+          address < sizeof(Chip8State::memory8_4kb));
+}
+
+Chip8Env* chip8_env_create(char const* rom, uint32_t envs,
+                           uint32_t instructions_per_frame,
+                           uint32_t frames_per_step, uint32_t threads) {
+  if (rom == nullptr || envs == 0 || instructions_per_frame == 0 ||
+      frames_per_step == 0) {
+    return nullptr;
+  }
+
+  Chip8 prototype;
+
+  if (!prototype.LoadRom(rom)) {
+    return nullptr;
+  }
+
+  // 0 threads -> one per host core
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // No exceptions across the C boundary
+  try {
+    return new Chip8Env(prototype, envs, frames_per_step,
+                        instructions_per_frame, threads);
+  } catch (std::exception const&) {
+    return nullptr;
+  }
+}
+
+void chip8_env_destroy(Chip8Env* env) { delete env; }
+
+uint32_t chip8_env_count(Chip8Env const* env) {
+  return static_cast<uint32_t>(env->machines.size());
+}
+
+int chip8_env_add_reward(Chip8Env* env, int source, uint32_t address,
+                         float scale) {
+  if (!ValidHook(source, address)) {
+    return -1;
+  }
+
+  // Baselines are [env][hook] -> rebuild with the new hook's current value
+  std::size_t hooks = env->rewards_from.size();
+  std::vector<uint8_t> baseline;
+  EnvHook hook{source, address, scale, 0};
+
+  for (std::size_t i = 0; i < env->machines.size(); ++i) {
+    auto from = env->baseline.begin() + i * hooks;
+    baseline.insert(baseline.end(), from, from + hooks);
+    baseline.push_back(env->Read(env->machines[i], hook));
+  }
+
+  env->rewards_from.push_back(hook);
+  env->baseline.swap(baseline);
+  return 0;
+}
+
+int chip8_env_add_done(Chip8Env* env, int source, uint32_t address,
+                       uint8_t value) {
+  if (!ValidHook(source, address)) {
+    return -1;
+  }
+
+  env->dones_from.push_back(EnvHook{source, address, 0.0f, value});
+  return 0;
+}
+
+void chip8_env_reset(Chip8Env* env, uint64_t seed) {
+  for (uint32_t i = 0; i < env->machines.size(); ++i) {
+    env->machines[i].Seed(seed + i);
+    env->Restart(i);
+  }
+
+  std::fill(env->rewards.begin(), env->rewards.end(), 0.0f);
+  std::fill(env->dones.begin(), env->dones.end(), uint8_t{0});
+}
+
+void chip8_env_step(Chip8Env* env, int32_t const* actions) {
+  env->actions = actions;
+  env->finished.store(0, std::memory_order_relaxed);
+
+  {
+    std::lock_guard<std::mutex> lock(env->wake_mutex);
+    env->generation.fetch_add(1, std::memory_order_release);
+  }
+
+  env->wake.notify_all();
+  env->StepRange(0);
+
+  // Helpers' envs done -> their writes are visible (acquire)
+  while (env->finished.load(std::memory_order_acquire) + 1 <
+         env->thread_count) {
+    std::this_thread::yield();
+  }
+}
+
+uint64_t const* chip8_env_observations(Chip8Env const* env, size_t* stride) {
+  if (stride != nullptr) {
+    *stride = sizeof(Chip8);
+  }
+
+  return env->machines[0].video64_32;
+}
+
+float const* chip8_env_rewards(Chip8Env const* env) {
+  return env->rewards.data();
+}
+
+uint8_t const* chip8_env_dones(Chip8Env const* env) {
+  return env->dones.data();
+}
@@ -0,0 +1,75 @@
+#ifndef CHIP8_ENV_API_H
+
+#define CHIP8_ENV_API_H
+
+// C ABI for reinforcement learning: N copies of one ROM stepped a frame
+// (or several) per call on a thread pool. Plain C so it loads through
+// Python's ctypes (`make env` -> bin/linux/libchip8env.so).
+//
+// Observations are the machines' own display rows, read in place: env i's
+// 32 rows of 64 pixels (uint64_t, MSB = x 0) start at
+// chip8_env_observations() + i * stride bytes and stay valid until
+// chip8_env_destroy(). Rewards and dones are arrays of N, rewritten by
+// every step. Not thread-safe: call from one thread at a time.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define CHIP8_ENV_EXPORT __declspec(dllexport)
+#else
+#define CHIP8_ENV_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Chip8Env Chip8Env;
+
+#define CHIP8_ENV_NO_KEY (-1)  // action: nothing held
+
+// What a reward or done hook reads
+#define CHIP8_ENV_REGISTER 0  // V0-VF, address 0-15
+#define CHIP8_ENV_MEMORY 1    // memory8_4kb, address 0-4095
+
+// `envs` copies of `rom` (quirks from its .quirks file). Each step runs
+// `frames_per_step` frames of `instructions_per_frame` with the action's
+// key held. `threads` 0 = one per host core. NULL if the ROM is unreadable
+// or an argument is 0
+CHIP8_ENV_EXPORT Chip8Env* chip8_env_create(char const* rom, uint32_t envs,
+                                            uint32_t instructions_per_frame,
+                                            uint32_t frames_per_step,
+                                            uint32_t threads);
+CHIP8_ENV_EXPORT void chip8_env_destroy(Chip8Env* env);
+
+CHIP8_ENV_EXPORT uint32_t chip8_env_count(Chip8Env const* env);
+
+// Per step reward += scale * (value after - value before) of the byte at
+// `address`; a score or lives counter. 0 on success, -1 if out of range
+CHIP8_ENV_EXPORT int chip8_env_add_reward(Chip8Env* env, int source,
+                                          uint32_t address, float scale);
+
+// Episode ends when the byte at `address` equals `value` after a step; the
+// env then restarts from the loaded ROM by itself (its Cxnn sequence goes
+// on, so episodes differ). 0 on success, -1 if out of range
+CHIP8_ENV_EXPORT int chip8_env_add_done(Chip8Env* env, int source,
+                                        uint32_t address, uint8_t value);
+
+// Every env back to the loaded ROM, env i seeded with seed + i
+CHIP8_ENV_EXPORT void chip8_env_reset(Chip8Env* env, uint64_t seed);
+
+// One step of every env in parallel; actions[i] = key 0-15 held by env i
+// for the whole step, or CHIP8_ENV_NO_KEY
+CHIP8_ENV_EXPORT void chip8_env_step(Chip8Env* env, int32_t const* actions);
+
+CHIP8_ENV_EXPORT uint64_t const* chip8_env_observations(Chip8Env const* env,
+                                                        size_t* stride);
+CHIP8_ENV_EXPORT float const* chip8_env_rewards(Chip8Env const* env);
+CHIP8_ENV_EXPORT uint8_t const* chip8_env_dones(Chip8Env const* env);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CHIP8_ENV_API_H
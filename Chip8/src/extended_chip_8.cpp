@@ -0,0 +1,836 @@
+#include "extended_chip_8.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include "rom_cache.h"
+
+extern uint8_t fontset[FONTSET_SIZE];  // chip_8.cpp
+
+// 8x10 hex digits for Fx30 (SUPER-CHIP only has 0-9; XO-CHIP all 16)
+static uint8_t const BIG_FONTSET[BIG_FONTSET_SIZE] = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C,  // 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C,  // 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF,  // 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C,  // 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06,  // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C,  // 5
+    0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C,  // 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60,  // 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C,  // 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C,  // 9
+    0x18, 0x3C, 0x66, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3,  // A
+    0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC,  // B
+    0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C,  // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,  // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF,  // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0   // F
+};
+
+// Each bit twice: a lo-res sprite row at hi-res size
+static uint32_t Double(uint32_t bits, unsigned int width) {
+  uint32_t doubled = 0;
+
+  for (unsigned int i = 0; i < width; ++i) {
+    doubled |= ((bits >> i) & 1u) * (3u << (2 * i));
+  }
+
+  return doubled;
+}
+
+// Sprite row `bits` (`width` <= 32 wide, MSB first) with its first bit on
+// column x of a 128-column row -> the row's two words. Bits past column 127
+// fall off, or come back in at column 0 if `wrap`
+static void Place(uint32_t bits, unsigned int width, unsigned int x,
+                  bool wrap, uint64_t words[HIRES_ROW_WORDS]) {
+  uint64_t sprite = uint64_t{bits} << (64 - width);
+
+  if (x < 64) {
+    words[0] = sprite >> x;
+    words[1] = x > 0 ? sprite << (64 - x) : 0;
+  } else {
+    words[0] = wrap && x > 64 ? sprite << (128 - x) : 0;
+    words[1] = sprite >> (x - 64);
+  }
+}
+
+template <typename Mode>
+ExtendedChip8<Mode>::ExtendedChip8() {
+  pc16 = START_ADDRESS;
+  random64 = std::chrono::system_clock::now().time_since_epoch().count();
+
+  std::copy(fontset, fontset + FONTSET_SIZE, &memory8[FONTSET_START_ADDRESS]);
+  std::copy(BIG_FONTSET, BIG_FONTSET + BIG_FONTSET_SIZE,
+            &memory8[BIG_FONTSET_START_ADDRESS]);
+
+  std::fill(std::begin(table0), std::end(table0), &ExtendedChip8::Op_NULL);
+  std::fill(std::begin(table5), std::end(table5), &ExtendedChip8::Op_NULL);
+  std::fill(std::begin(table8), std::end(table8), &ExtendedChip8::Op_NULL);
+  std::fill(std::begin(tableE), std::end(tableE), &ExtendedChip8::Op_NULL);
+  std::fill(std::begin(tableF), std::end(tableF), &ExtendedChip8::Op_NULL);
+
+  // #
+  table[0x0] = &ExtendedChip8::Table0;
+  table[0x1] = &ExtendedChip8::Op_1nnn;
+  table[0x2] = &ExtendedChip8::Op_2nnn;
+  table[0x3] = &ExtendedChip8::Op_3xnn;
+  table[0x4] = &ExtendedChip8::Op_4xnn;
+  table[0x5] = &ExtendedChip8::Op_5xy0;
+  table[0x6] = &ExtendedChip8::Op_6xnn;
+  table[0x7] = &ExtendedChip8::Op_7xnn;
+  table[0x8] = &ExtendedChip8::Table8;
+  table[0x9] = &ExtendedChip8::Op_9xy0;
+  table[0xA] = &ExtendedChip8::Op_Annn;
+  table[0xB] = &ExtendedChip8::Op_Bnnn;
+  table[0xC] = &ExtendedChip8::Op_Cxnn;
+  table[0xD] = &ExtendedChip8::Op_Dxyn;
+  table[0xE] = &ExtendedChip8::TableE;
+  table[0xF] = &ExtendedChip8::TableF;
+
+  // 0 (whole low byte: 00Cn, 00E0, 00FB...)
+  for (unsigned int n = 0; n <= 0xF; ++n) {
+    table0[0xC0 + n] = &ExtendedChip8::Op_00Cn;
+  }
+
+  table0[0xE0] = &ExtendedChip8::Op_00E0;
+  table0[0xEE] = &ExtendedChip8::Op_00EE;
+  table0[0xFB] = &ExtendedChip8::Op_00FB;
+  table0[0xFC] = &ExtendedChip8::Op_00FC;
+  table0[0xFD] = &ExtendedChip8::Op_00FD;
+  table0[0xFE] = &ExtendedChip8::Op_00FE;
+  table0[0xFF] = &ExtendedChip8::Op_00FF;
+
+  // 8
+  table8[0x0] = &ExtendedChip8::Op_8xy0;
+  table8[0x1] = &ExtendedChip8::Op_8xy1;
+  table8[0x2] = &ExtendedChip8::Op_8xy2;
+  table8[0x3] = &ExtendedChip8::Op_8xy3;
+  table8[0x4] = &ExtendedChip8::Op_8xy4;
+  table8[0x5] = &ExtendedChip8::Op_8xy5;
+  table8[0x6] = &ExtendedChip8::Op_8xy6;
+  table8[0x7] = &ExtendedChip8::Op_8xy7;
+  table8[0xE] = &ExtendedChip8::Op_8xyE;
+
+  // E
+  tableE[0x1] = &ExtendedChip8::Op_ExA1;
+  tableE[0xE] = &ExtendedChip8::Op_Ex9E;
+
+  // F
+  tableF[0x07] = &ExtendedChip8::Op_Fx07;
+  tableF[0x0A] = &ExtendedChip8::Op_Fx0A;
+  tableF[0x15] = &ExtendedChip8::Op_Fx15;
+  tableF[0x18] = &ExtendedChip8::Op_Fx18;
+  tableF[0x1E] = &ExtendedChip8::Op_Fx1E;
+  tableF[0x29] = &ExtendedChip8::Op_Fx29;
+  tableF[0x30] = &ExtendedChip8::Op_Fx30;
+  tableF[0x33] = &ExtendedChip8::Op_Fx33;
+  tableF[0x55] = &ExtendedChip8::Op_Fx55;
+  tableF[0x65] = &ExtendedChip8::Op_Fx65;
+  tableF[0x75] = &ExtendedChip8::Op_Fx75;
+  tableF[0x85] = &ExtendedChip8::Op_Fx85;
+
+  if constexpr (Mode::XO_CHIP) {
+    for (unsigned int n = 0; n <= 0xF; ++n) {
+      table0[0xD0 + n] = &ExtendedChip8::Op_00Dn;
+    }
+
+    table[0x5] = &ExtendedChip8::Table5;
+    table5[0x0] = &ExtendedChip8::Op_5xy0;
+    table5[0x2] = &ExtendedChip8::Op_5xy2;
+    table5[0x3] = &ExtendedChip8::Op_5xy3;
+
+    tableF[0x00] = &ExtendedChip8::Op_F000;
+    tableF[0x01] = &ExtendedChip8::Op_Fn01;
+    tableF[0x02] = &ExtendedChip8::Op_F002;
+    tableF[0x3A] = &ExtendedChip8::Op_Fx3A;
+  }
+}
+
+template <typename Mode>
+bool ExtendedChip8<Mode>::LoadRom(char const* filename) {
+  std::shared_ptr<RomImage const> rom =
+      RomCache::Global().Load(filename, MAX_ROM_SIZE);
+
+  if (rom == nullptr) {
+    return false;
+  }
+
+  LoadRom(*rom);
+  return true;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::LoadRom(RomImage const& rom) {
+  std::memcpy(&memory8[START_ADDRESS], rom.bytes.data(),
+              std::min<std::size_t>(rom.bytes.size(), MAX_ROM_SIZE));
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Cycle() {
+  uint16_t pc = pc16 % Mode::MEMORY_SIZE;
+  opcode16 = (memory8[pc] << 8u) | memory8[(pc + 1) % Mode::MEMORY_SIZE];
+
+  pc16 += 2;
+
+  ((*this).*(table[(opcode16 & 0xF000u) >> 12u]))();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::TickTimers() {
+  if (delay_timer8 > 0) {
+    --delay_timer8;
+  }
+
+  if (sound_timer8 > 0) {
+    --sound_timer8;
+  }
+}
+
+template <typename Mode>
+unsigned int ExtendedChip8<Mode>::StepFrame(unsigned int instructions) {
+  unsigned int i = 0;
+
+  for (; i < instructions && !Halted(); ++i) {
+    Cycle();
+  }
+
+  TickTimers();
+  return i;
+}
+
+template <typename Mode>
+bool ExtendedChip8<Mode>::Wake() {
+  if (FirstKeyDown(keypad8_16) < 0) {
+    return false;
+  }
+
+  key_wait8 = 0;
+  return true;
+}
+
+template <typename Mode>
+uint16_t ExtendedChip8<Mode>::Address(unsigned int offset) const {
+  return (index16 + offset) % Mode::MEMORY_SIZE;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Skip() {
+  if constexpr (Mode::XO_CHIP) {
+    uint16_t pc = pc16 % Mode::MEMORY_SIZE;
+
+    if (memory8[pc] == 0xF0 && memory8[(pc + 1) % Mode::MEMORY_SIZE] == 0x00) {
+      pc16 += 2;  // F000 nnnn -> skip the nnnn too
+    }
+  }
+
+  pc16 += 2;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Clear() {
+  for (unsigned int plane = 0; plane < Mode::PLANES; ++plane) {
+    if (planes8 & (1u << plane)) {
+      std::memset(video[plane], 0, sizeof(video[plane]));
+    }
+  }
+
+  dirty_rows64 = ~uint64_t{0};
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::ScrollRows(int rows) {
+  // Lo-res scrolls in lo-res pixels
+  rows *= hires ? 1 : 2;
+
+  for (unsigned int plane = 0; plane < Mode::PLANES; ++plane) {
+    if (!(planes8 & (1u << plane))) {
+      continue;
+    }
+
+    uint64_t(&display)[HIRES_HEIGHT][HIRES_ROW_WORDS] = video[plane];
+
+    for (unsigned int i = 0; i < HIRES_HEIGHT; ++i) {
+      // Down -> walk up from the bottom so no source is overwritten first
+      int y = rows > 0 ? HIRES_HEIGHT - 1 - i : i;
+      int from = y - rows;
+      bool inside = from >= 0 && from < static_cast<int>(HIRES_HEIGHT);
+
+      for (unsigned int word = 0; word < HIRES_ROW_WORDS; ++word) {
+        display[y][word] = inside ? display[from][word] : 0;
+      }
+    }
+  }
+
+  dirty_rows64 = ~uint64_t{0};
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::ScrollColumns(int columns) {
+  columns *= hires ? 1 : 2;
+
+  unsigned int shift = columns > 0 ? columns : -columns;
+
+  for (unsigned int plane = 0; plane < Mode::PLANES; ++plane) {
+    if (!(planes8 & (1u << plane))) {
+      continue;
+    }
+
+    for (uint64_t* row : video[plane]) {
+      if (columns > 0) {
+        row[1] = (row[1] >> shift) | (row[0] << (64 - shift));
+        row[0] >>= shift;
+      } else {
+        row[0] = (row[0] << shift) | (row[1] >> (64 - shift));
+        row[1] <<= shift;
+      }
+    }
+  }
+
+  dirty_rows64 = ~uint64_t{0};
+}
+
+template <typename Mode>
+uint8_t ExtendedChip8<Mode>::RandomByte() {
+  // SplitMix64, as Chip8::RandomByte()
+  uint64_t z = (random64 += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+
+  return static_cast<uint8_t>((z ^ (z >> 31u)) >> 56u);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Table0() {
+  ((*this).*(table0[opcode16 & 0x00FFu]))();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Table5() {
+  ((*this).*(table5[opcode16 & 0x000Fu]))();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Table8() {
+  ((*this).*(table8[opcode16 & 0x000Fu]))();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::TableE() {
+  ((*this).*(tableE[opcode16 & 0x000Fu]))();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::TableF() {
+  ((*this).*(tableF[opcode16 & 0x00FFu]))();
+}
+
+// ---------------------------------------------------------------- CHIP-8 //
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_NULL() {}  // Do nothing
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00E0() {  // CLS
+  Clear();
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00EE() {  // RET
+  sp8 = (sp8 - 1) & 0x0Fu;  // 16 levels, wraps instead of leaving the stack
+  pc16 = stack16_16[sp8];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_1nnn() {  // JMP
+  pc16 = opcode16 & 0x0FFFu;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_2nnn() {  // CALL
+  stack16_16[sp8 & 0x0Fu] = pc16;
+  sp8 = (sp8 + 1) & 0x0Fu;
+
+  pc16 = opcode16 & 0x0FFFu;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_3xnn() {  // Skip next instruction if Vx = nn
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  if (registers8_16[v_x] == (opcode16 & 0x00FFu)) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_4xnn() {  // Skip next instruction if Vx != nn
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  if (registers8_16[v_x] != (opcode16 & 0x00FFu)) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_5xy0() {  // Skip next instruction if Vx = Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  if (registers8_16[v_x] == registers8_16[v_y]) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_6xnn() {  // Set Vx = nn
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  registers8_16[v_x] = opcode16 & 0x00FFu;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_7xnn() {  // Set Vx = Vx + nn
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  registers8_16[v_x] += opcode16 & 0x00FFu;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy0() {  // Set Vx = Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  registers8_16[v_x] = registers8_16[v_y];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy1() {  // Set Vx = Vx OR Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  registers8_16[v_x] |= registers8_16[v_y];
+
+  if (Mode::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy2() {  // Set Vx = Vx AND Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  registers8_16[v_x] &= registers8_16[v_y];
+
+  if (Mode::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy3() {  // Set Vx = Vx XOR Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  registers8_16[v_x] ^= registers8_16[v_y];
+
+  if (Mode::LOGIC_RESETS_VF) {
+    registers8_16[0xF] = 0;
+  }
+}
+
+// The arithmetic ops write the result first, then VF -> with x = F, VF ends
+// up holding the flag (as on both SUPER-CHIP and XO-CHIP). The flag values
+// are Chip8's: carry = sum > 0xFF, 8xy5/8xy7 per SubtractFlag (chip_8.h)
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy4() {  // Set Vx = Vx + Vy | Vf = carry
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  unsigned int sum = registers8_16[v_x] + registers8_16[v_y];
+
+  registers8_16[v_x] = sum & 0xFFu;
+  registers8_16[0xF] = sum > 0xFFu ? 1 : 0;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy5() {  // Set Vx = Vx - Vy | Vf = Vx > Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  uint8_t flag = SubtractFlag(registers8_16[v_x], registers8_16[v_y]);
+
+  registers8_16[v_x] -= registers8_16[v_y];
+  registers8_16[0xF] = flag;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy6() {  // Vx = Vx (or Vy) >> 1 | Vf = LSB
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  uint8_t value = registers8_16[Mode::SHIFT_VY ? v_y : v_x];
+
+  registers8_16[v_x] = value >> 1u;
+  registers8_16[0xF] = value & 0x1u;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xy7() {  // Set Vx = Vy - Vx | Vf = Vy > Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  uint8_t flag = SubtractFlag(registers8_16[v_y], registers8_16[v_x]);
+
+  registers8_16[v_x] = registers8_16[v_y] - registers8_16[v_x];
+  registers8_16[0xF] = flag;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_8xyE() {  // Vx = Vx (or Vy) << 1 | Vf = MSB
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  uint8_t value = registers8_16[Mode::SHIFT_VY ? v_y : v_x];
+
+  registers8_16[v_x] = value << 1u;
+  registers8_16[0xF] = value >> 7u;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_9xy0() {  // Skip next instruction if Vx != Vy
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+
+  if (registers8_16[v_x] != registers8_16[v_y]) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Annn() {  // Set index16 = nnn
+  index16 = opcode16 & 0x0FFFu;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Bnnn() {  // Jump to nnn + V0 (or xnn + Vx)
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  pc16 = (opcode16 & 0x0FFFu) + registers8_16[Mode::JUMP_VX ? v_x : 0];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Cxnn() {  // Set Vx = random number AND nn
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  registers8_16[v_x] = RandomByte() & (opcode16 & 0x00FFu);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Dxyn() {  // Draw an 8xn sprite @(Vx, Vy), or
+                                       // 16x16 for n = 0, on every selected
+                                       // plane (their data back to back)
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t v_y = (opcode16 & 0x00F0u) >> 4u;
+  unsigned int n = opcode16 & 0x000Fu;
+
+  // Lo-res: 64x32 coordinates, every pixel a 2x2 block of the display
+  unsigned int scale = hires ? 1 : 2;
+  unsigned int x = (registers8_16[v_x] * scale) % HIRES_WIDTH;
+  unsigned int y = (registers8_16[v_y] * scale) % HIRES_HEIGHT;
+
+  unsigned int width = n == 0 ? 16 : 8;
+  unsigned int height = n == 0 ? 16 : n;
+  unsigned int row_bytes = width / 8;
+
+  unsigned int offset = 0;  // into the sprite data @index16
+  unsigned int hit_rows = 0;  // sprite rows that collided or were clipped
+
+  for (unsigned int plane = 0; plane < Mode::PLANES; ++plane) {
+    if (!(planes8 & (1u << plane))) {
+      continue;
+    }
+
+    uint64_t(&display)[HIRES_HEIGHT][HIRES_ROW_WORDS] = video[plane];
+
+    for (unsigned int row = 0; row < height; ++row, offset += row_bytes) {
+      uint32_t bits = memory8[Address(offset)];
+
+      if (row_bytes == 2) {
+        bits = (bits << 8u) | memory8[Address(offset + 1)];
+      }
+
+      uint64_t words[HIRES_ROW_WORDS];
+      Place(scale == 2 ? Double(bits, width) : bits, width * scale, x,
+            Mode::WRAP_SPRITES, words);
+
+      bool hit = false;
+
+      for (unsigned int copy = 0; copy < scale; ++copy) {
+        unsigned int display_y = y + row * scale + copy;
+
+        if (display_y >= HIRES_HEIGHT) {
+          if (!Mode::WRAP_SPRITES) {
+            hit = true;  // clipped
+            break;
+          }
+
+          display_y %= HIRES_HEIGHT;
+        }
+
+        uint64_t* line = display[display_y];
+
+        hit |= ((line[0] & words[0]) | (line[1] & words[1])) != 0;
+        line[0] ^= words[0];
+        line[1] ^= words[1];
+
+        dirty_rows64 |= uint64_t{(words[0] | words[1]) != 0} << display_y;
+      }
+
+      hit_rows += hit;
+    }
+  }
+
+  // SUPER-CHIP hi-res counts the rows; otherwise VF = any collision
+  if (!Mode::XO_CHIP && hires) {
+    registers8_16[0xF] = hit_rows;
+  } else {
+    registers8_16[0xF] = hit_rows != 0 ? 1 : 0;
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Ex9E() {  // Skip next instruction if key Vx
+                                       // is pressed
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  if (keypad8_16[registers8_16[v_x] & 0x0Fu]) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_ExA1() {  // Skip next instruction if key Vx
+                                       // is ~pressed
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  if (!keypad8_16[registers8_16[v_x] & 0x0Fu]) {
+    Skip();
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx07() {  // Set Vx = delay_timer8
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  registers8_16[v_x] = delay_timer8;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx0A() {  // Wait for key press, store it in Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  int key = FirstKeyDown(keypad8_16);
+
+  if (key >= 0) {
+    registers8_16[v_x] = static_cast<uint8_t>(key);
+    return;
+  }
+
+  // No key -> halt on this instruction; see Halted()
+  pc16 -= 2;
+  key_wait8 = 1;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx15() {  // Set delay_timer8 = Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  delay_timer8 = registers8_16[v_x];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx18() {  // Set sound_timer8 = Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  sound_timer8 = registers8_16[v_x];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx1E() {  // Set index16 = index16 + Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  index16 += registers8_16[v_x];
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx29() {  // Set index16 = small font digit Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  index16 = FONTSET_START_ADDRESS + (registers8_16[v_x] & 0x0Fu) * 5;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx33() {  // Store BCD of Vx @index16..+2
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+  uint8_t value = registers8_16[v_x];
+
+  memory8[Address(0)] = value / 100;
+  memory8[Address(1)] = (value / 10) % 10;
+  memory8[Address(2)] = value % 10;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx55() {  // Store V0..Vx @index16
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  for (unsigned int i = 0; i <= v_x; ++i) {
+    memory8[Address(i)] = registers8_16[i];
+  }
+
+  if (Mode::LOAD_STORE_INCREMENTS_I) {
+    index16 += v_x + 1;
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx65() {  // Fill V0..Vx from @index16
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  for (unsigned int i = 0; i <= v_x; ++i) {
+    registers8_16[i] = memory8[Address(i)];
+  }
+
+  if (Mode::LOAD_STORE_INCREMENTS_I) {
+    index16 += v_x + 1;
+  }
+}
+
+// ------------------------------------------------------------ SUPER-CHIP //
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00Cn() {  // Scroll down n rows
+  ScrollRows(opcode16 & 0x000Fu);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00FB() {  // Scroll right 4 columns
+  ScrollColumns(4);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00FC() {  // Scroll left 4 columns
+  ScrollColumns(-4);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00FD() {  // Exit: stay on this instruction
+  exited = true;
+  pc16 -= 2;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00FE() {  // Lo-res, clears the display
+  hires = false;
+  std::memset(video, 0, sizeof(video));
+  dirty_rows64 = ~uint64_t{0};
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00FF() {  // Hi-res, clears the display
+  hires = true;
+  std::memset(video, 0, sizeof(video));
+  dirty_rows64 = ~uint64_t{0};
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx30() {  // Set index16 = big font digit Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  index16 = BIG_FONTSET_START_ADDRESS + (registers8_16[v_x] & 0x0Fu) * 10;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx75() {  // Save V0..Vx to the user flags
+  unsigned int v_x = (opcode16 & 0x0F00u) >> 8u;
+  unsigned int last = std::min(v_x, Mode::FLAG_REGISTERS - 1);
+
+  std::copy(registers8_16, registers8_16 + last + 1, flags8_16);
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx85() {  // Restore V0..Vx from the user flags
+  unsigned int v_x = (opcode16 & 0x0F00u) >> 8u;
+  unsigned int last = std::min(v_x, Mode::FLAG_REGISTERS - 1);
+
+  std::copy(flags8_16, flags8_16 + last + 1, registers8_16);
+}
+
+// --------------------------------------------------------------- XO-CHIP //
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_00Dn() {  // Scroll up n rows
+  ScrollRows(-static_cast<int>(opcode16 & 0x000Fu));
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_5xy2() {  // Store Vx..Vy (either order)
+  unsigned int v_x = (opcode16 & 0x0F00u) >> 8u;
+  unsigned int v_y = (opcode16 & 0x00F0u) >> 4u;
+  int step = v_x <= v_y ? 1 : -1;
+
+  for (unsigned int i = 0, v = v_x;; ++i, v += step) {
+    memory8[Address(i)] = registers8_16[v];
+
+    if (v == v_y) {
+      break;
+    }
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_5xy3() {  // Load Vx..Vy (either order)
+  unsigned int v_x = (opcode16 & 0x0F00u) >> 8u;
+  unsigned int v_y = (opcode16 & 0x00F0u) >> 4u;
+  int step = v_x <= v_y ? 1 : -1;
+
+  for (unsigned int i = 0, v = v_x;; ++i, v += step) {
+    registers8_16[v] = memory8[Address(i)];
+
+    if (v == v_y) {
+      break;
+    }
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_F000() {  // Set index16 = next word, skip it
+  uint16_t pc = pc16 % Mode::MEMORY_SIZE;
+
+  index16 = (memory8[pc] << 8u) | memory8[(pc + 1) % Mode::MEMORY_SIZE];
+  pc16 += 2;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fn01() {  // Select planes n (bit 0 = plane 1)
+  planes8 = ((opcode16 & 0x0F00u) >> 8u) & 0x3u;
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_F002() {  // Load the 16-byte audio pattern
+  for (unsigned int i = 0; i < sizeof(pattern8_16); ++i) {
+    pattern8_16[i] = memory8[Address(i)];
+  }
+}
+
+template <typename Mode>
+void ExtendedChip8<Mode>::Op_Fx3A() {  // Set pitch8 = Vx
+  uint8_t v_x = (opcode16 & 0x0F00u) >> 8u;
+
+  pitch8 = registers8_16[v_x];
+}
+
+template class ExtendedChip8<SuperChipMode>;
+template class ExtendedChip8<XoChipMode>;
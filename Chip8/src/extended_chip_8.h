@@ -0,0 +1,214 @@
+#ifndef CHIP8_EXTENDED_CHIP_8_H
+
+#define CHIP8_EXTENDED_CHIP_8_H
+
+#include <cstdint>
+
+#include "chip_8.h"
+#include "quirks.h"
+
+struct RomImage;  // rom_cache.h
+
+const unsigned int HIRES_WIDTH = 128;  // SUPER-CHIP/XO-CHIP display; lo-res
+const unsigned int HIRES_HEIGHT = 64;  // is 64x32 drawn as 2x2 blocks
+const unsigned int HIRES_ROW_WORDS = HIRES_WIDTH / 64;
+const unsigned int BIG_FONTSET_SIZE = 160;  // 16 chars (0 to F), 10 B each
+const unsigned int BIG_FONTSET_START_ADDRESS =
+    FONTSET_START_ADDRESS + FONTSET_SIZE;  // right after the small font
+
+// A CHIP-8 extension, fixed at compile time: every "which machine is this"
+// question a handler would ask is one of these constants, its quirks those
+// of the machine's QuirkPolicy (quirks.h)
+
+// SUPER-CHIP 1.1
+struct SuperChipMode : SuperChipQuirks {
+  static constexpr char const* NAME = "schip";
+  static constexpr unsigned int MEMORY_SIZE = 4096;
+  static constexpr unsigned int PLANES = 1;
+  static constexpr unsigned int FLAG_REGISTERS = 8;  // Fx75/Fx85: V0..V7
+  static constexpr bool XO_CHIP = false;  // F000, 5xy2/3, Fn01, F002, Fx3A,
+                                          // 00Dn
+};
+
+// XO-CHIP (as Octo runs it)
+struct XoChipMode : XoChipQuirks {
+  static constexpr char const* NAME = "xochip";
+  static constexpr unsigned int MEMORY_SIZE = 65536;
+  static constexpr unsigned int PLANES = 2;
+  static constexpr unsigned int FLAG_REGISTERS = 16;
+  static constexpr bool XO_CHIP = true;
+};
+
+// Everything that affects execution, trivially copyable like Chip8State
+template <typename Mode>
+struct ExtendedState {
+  uint8_t registers8_16[16]{};
+  uint8_t memory8[Mode::MEMORY_SIZE]{};
+  uint16_t index16{};
+  uint16_t pc16{};
+  uint16_t stack16_16[16]{};
+  uint8_t sp8{};
+  uint8_t delay_timer8{};
+  uint8_t sound_timer8{};
+  uint8_t keypad8_16[16]{};
+  uint8_t key_wait8{};  // 1: halted in Fx0A, as in Chip8State
+
+  // [plane][y][word], always 128x64: MSB of word 0 = x 0, of word 1 = x 64
+  uint64_t video[Mode::PLANES][HIRES_HEIGHT][HIRES_ROW_WORDS]{};
+
+  uint8_t flags8_16[16]{};    // Fx75/Fx85 user flags (HP-48 "RPL")
+  uint8_t planes8{1};         // planes Dxyn/00E0/scrolls act on (Fn01)
+  uint8_t pattern8_16[16]{};  // XO-CHIP 1-bit audio pattern (F002)
+  uint8_t pitch8{64};         // XO-CHIP pattern playback pitch (Fx3A)
+  bool hires{};               // 00FF -> 128x64, 00FE -> 64x32
+  bool exited{};              // 00FD ran -> the ROM is done
+  uint16_t opcode16{};
+  uint64_t random64{};  // Cxnn generator state (SplitMix64)
+};
+
+// SUPER-CHIP or XO-CHIP: the CHIP-8 instruction set with `Mode`'s
+// additions and behaviour, on a 128x64 display. A machine of its own, not
+// a Chip8 flag -> Chip8 keeps its 64x32 rows and tables, and each Mode gets
+// its own dispatch tables with its extension checks resolved at compile time
+template <typename Mode>
+class ExtendedChip8 : public ExtendedState<Mode> {
+ public:
+  static constexpr unsigned int MAX_ROM_SIZE =
+      Mode::MEMORY_SIZE - START_ADDRESS;
+  static constexpr bool XO_CHIP = Mode::XO_CHIP;  // pattern8_16/pitch8 used
+
+  uint64_t dirty_rows64{};  // bit y: row y changed since present (not state)
+
+  ExtendedChip8();
+
+  // Same as Chip8's: by path through RomCache::Global() (false if
+  // unreadable or over MAX_ROM_SIZE bytes), or from an image
+  bool LoadRom(char const* rom);
+  void LoadRom(RomImage const& rom);
+
+  void Seed(uint64_t seed) { random64 = seed; }
+  void Cycle();
+  void TickTimers();
+  unsigned int StepFrame(unsigned int instructions);  // instructions run
+
+  // Same halt as Chip8::Halted(): Fx0A with no key down
+  bool Halted() { return key_wait8 != 0 && !Wake(); }
+
+  // Chip8::SkipIdle() counterpart; no idle-loop detection on these
+  // machines -> nothing is ever skipped
+  unsigned int SkipIdle(unsigned int) { return 0; }
+
+  // For Platform::Update(rows, HIRES_ROW_WORDS, Mode::PLANES, dirty_rows64)
+  uint64_t const* Video() const { return &video[0][0][0]; }
+
+  using ExtendedState<Mode>::registers8_16;
+  using ExtendedState<Mode>::memory8;
+  using ExtendedState<Mode>::index16;
+  using ExtendedState<Mode>::pc16;
+  using ExtendedState<Mode>::stack16_16;
+  using ExtendedState<Mode>::sp8;
+  using ExtendedState<Mode>::delay_timer8;
+  using ExtendedState<Mode>::sound_timer8;
+  using ExtendedState<Mode>::keypad8_16;
+  using ExtendedState<Mode>::key_wait8;
+  using ExtendedState<Mode>::video;
+  using ExtendedState<Mode>::flags8_16;
+  using ExtendedState<Mode>::planes8;
+  using ExtendedState<Mode>::pattern8_16;
+  using ExtendedState<Mode>::pitch8;
+  using ExtendedState<Mode>::hires;
+  using ExtendedState<Mode>::exited;
+  using ExtendedState<Mode>::opcode16;
+  using ExtendedState<Mode>::random64;
+
+ private:
+  bool Wake();  // clears the halt if a key is down
+
+  void Table0();
+  void Table5();
+  void Table8();
+  void TableE();
+  void TableF();
+
+  // CHIP-8 (see the reference in chip_8.h)
+  void Op_NULL();
+  void Op_00E0();
+  void Op_00EE();
+  void Op_1nnn();
+  void Op_2nnn();
+  void Op_3xnn();
+  void Op_4xnn();
+  void Op_5xy0();
+  void Op_6xnn();
+  void Op_7xnn();
+  void Op_8xy0();
+  void Op_8xy1();
+  void Op_8xy2();
+  void Op_8xy3();
+  void Op_8xy4();
+  void Op_8xy5();
+  void Op_8xy6();
+  void Op_8xy7();
+  void Op_8xyE();
+  void Op_9xy0();
+  void Op_Annn();
+  void Op_Bnnn();
+  void Op_Cxnn();
+  void Op_Dxyn();  // + Dxy0: 16x16 sprite
+  void Op_Ex9E();
+  void Op_ExA1();
+  void Op_Fx07();
+  void Op_Fx0A();
+  void Op_Fx15();
+  void Op_Fx18();
+  void Op_Fx1E();
+  void Op_Fx29();
+  void Op_Fx33();
+  void Op_Fx55();
+  void Op_Fx65();
+
+  // SUPER-CHIP
+  void Op_00Cn();  // scroll down n rows
+  void Op_00FB();  // scroll right 4 columns
+  void Op_00FC();  // scroll left 4 columns
+  void Op_00FD();  // exit
+  void Op_00FE();  // lo-res (64x32)
+  void Op_00FF();  // hi-res (128x64)
+  void Op_Fx30();  // index16 = big font digit Vx
+  void Op_Fx75();  // flags[0..x] = V0..Vx
+  void Op_Fx85();  // V0..Vx = flags[0..x]
+
+  // XO-CHIP
+  void Op_00Dn();  // scroll up n rows
+  void Op_5xy2();  // store Vx..Vy @index16 (index16 unchanged)
+  void Op_5xy3();  // load Vx..Vy from @index16 (index16 unchanged)
+  void Op_F000();  // index16 = the 16-bit word after the instruction
+  void Op_Fn01();  // planes8 = n
+  void Op_F002();  // pattern8_16 = 16 bytes @index16
+  void Op_Fx3A();  // pitch8 = Vx
+
+  uint16_t Address(unsigned int offset) const;  // index16 + offset, wrapped
+  void Skip();  // over the next instruction (F000 nnnn is 4 bytes)
+  void Clear();  // selected planes
+  void ScrollRows(int rows);        // > 0 down, < 0 up
+  void ScrollColumns(int columns);  // > 0 right, < 0 left
+  uint8_t RandomByte();
+
+  typedef void (ExtendedChip8::*Chip8Func)();
+
+  Chip8Func table[0xF + 1];
+  Chip8Func table0[0xFF + 1];
+  Chip8Func table5[0xF + 1];
+  Chip8Func table8[0xF + 1];
+  Chip8Func tableE[0xF + 1];
+  Chip8Func tableF[0xFF + 1];
+};
+
+using SuperChip8 = ExtendedChip8<SuperChipMode>;
+using XoChip8 = ExtendedChip8<XoChipMode>;
+
+// Both instantiated once, in extended_chip_8.cpp
+extern template class ExtendedChip8<SuperChipMode>;
+extern template class ExtendedChip8<XoChipMode>;
+
+#endif  // CHIP8_EXTENDED_CHIP_8_H
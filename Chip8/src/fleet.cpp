@@ -0,0 +1,218 @@
+#include "fleet.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "rom_cache.h"
+
+char const* CoreName(CoreKind core) {
+  switch (core) {
+    case CORE_TABLE: return "table";
+    case CORE_PREDECODED: return "predecoded";
+    case CORE_JIT: return "jit";
+    case CORE_AOT: return "aot";
+  }
+
+  return "unknown";
+}
+
+bool ParseCore(char const* name, CoreKind& core) {
+  for (CoreKind candidate : ALL_CORES) {
+    if (std::strcmp(name, CoreName(candidate)) == 0) {
+      core = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+double FleetStats::InstructionsPerSec() const {
+  return seconds > 0.0 ? instructions / seconds : 0.0;
+}
+
+double FleetStats::FramesPerSec() const {
+  return seconds > 0.0 ? frames / seconds : 0.0;
+}
+
+Fleet::Fleet(unsigned int threads, unsigned int instructions_per_frame,
+             CoreKind core)
+    : thread_count(threads),
+      instructions_per_frame(instructions_per_frame),
+      core(core) {
+  // 0 threads -> one worker per host core
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+  }
+
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+
+  for (unsigned int i = 0; i < thread_count; ++i) {
+    queues.push_back(std::make_unique<WorkQueue>());
+  }
+}
+
+bool Fleet::Add(char const* rom) {
+  // Every copy of a ROM shares one cached image -> one memcpy per instance
+  std::shared_ptr<RomImage const> image = RomCache::Global().Load(rom);
+
+  if (image == nullptr) {
+    return false;
+  }
+
+  // Heap-allocate each instance so no two share a cache line
+  instances.push_back(std::make_unique<Instance>());
+
+  Instance& instance = *instances.back();
+  instance.chip8.LoadRom(*image);
+
+  if (core == CORE_PREDECODED) {
+    instance.predecoded = std::make_unique<PredecodedCore>(instance.chip8);
+  }
+
+  if (core == CORE_JIT) {
+    instance.jit = std::make_unique<JitCore>(instance.chip8);
+  }
+
+  if (core == CORE_AOT) {
+    instance.aot = std::make_unique<AotCore>(instance.chip8);
+  }
+
+  return true;
+}
+
+FleetStats Fleet::Run(unsigned int frames) {
+  FleetStats stats;
+
+  if (instances.empty() || frames == 0) {
+    return stats;
+  }
+
+  // Deal instances round-robin onto the worker queues
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    queues[i % thread_count]->tasks.push_back(Task{i, frames});
+  }
+
+  unfinished = instances.size();
+
+  std::vector<uint64_t> instructions(thread_count, 0);
+  std::vector<std::thread> workers;
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  for (unsigned int w = 0; w < thread_count; ++w) {
+    workers.emplace_back(&Fleet::Worker, this, w, std::ref(instructions[w]));
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto end_time = std::chrono::steady_clock::now();
+
+  for (uint64_t count : instructions) {
+    stats.instructions += count;
+  }
+
+  for (auto const& instance : instances) {
+    stats.idle_skipped += instance->chip8.idle_skipped;
+  }
+
+  stats.frames = static_cast<uint64_t>(frames) * instances.size();
+  stats.seconds =
+      std::chrono::duration<double>(end_time - start_time).count();
+
+  return stats;
+}
+
+bool Fleet::Pop(unsigned int worker, Task& task) {
+  WorkQueue& queue = *queues[worker];
+  std::lock_guard<std::mutex> guard(queue.lock);
+
+  if (queue.tasks.empty()) {
+    return false;
+  }
+
+  // Owner takes from the back -> the instance it just ran stays cache-hot
+  task = queue.tasks.back();
+  queue.tasks.pop_back();
+
+  return true;
+}
+
+bool Fleet::Steal(unsigned int worker, Task& task) {
+  // Walk the other queues starting with our neighbour
+  for (unsigned int i = 1; i < thread_count; ++i) {
+    WorkQueue& victim = *queues[(worker + i) % thread_count];
+    std::lock_guard<std::mutex> guard(victim.lock);
+
+    if (!victim.tasks.empty()) {
+      // Thieves take from the front -> the coldest instance of the victim
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Fleet::Worker(unsigned int worker, uint64_t& instructions) {
+  uint64_t executed = 0;  // local count, published once at the end
+  Task task;
+
+  while (unfinished.load(std::memory_order_acquire) > 0) {
+    if (!Pop(worker, task) && !Steal(worker, task)) {
+      // Every remaining instance is being run by another worker
+      std::this_thread::yield();
+      continue;
+    }
+
+    Instance& instance = *instances[task.instance];
+
+    // Run a bounded slice so long runs can still be rebalanced
+    unsigned int slice = task.frames_left < FLEET_FRAMES_PER_SLICE
+                             ? task.frames_left
+                             : FLEET_FRAMES_PER_SLICE;
+
+    // Halted frames run nothing -> count what each frame actually ran
+    for (unsigned int frame = 0; frame < slice; ++frame) {
+      executed += StepFrame(instance);
+    }
+
+    task.frames_left -= slice;
+
+    if (task.frames_left > 0) {
+      WorkQueue& queue = *queues[worker];
+      std::lock_guard<std::mutex> guard(queue.lock);
+
+      queue.tasks.push_back(task);
+    } else {
+      unfinished.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  instructions = executed;
+}
+
+unsigned int Fleet::StepFrame(Instance& instance) {
+  switch (core) {
+    case CORE_TABLE:
+      return instance.chip8.StepFrame(instructions_per_frame);
+
+    case CORE_PREDECODED:
+      return instance.predecoded->StepFrame(instructions_per_frame);
+
+    case CORE_JIT:
+      return instance.jit->StepFrame(instructions_per_frame);
+
+    case CORE_AOT:
+      return instance.aot->StepFrame(instructions_per_frame);
+  }
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef CHIP8_FLEET_H
+
+#define CHIP8_FLEET_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "aot_core.h"
+#include "chip_8.h"
+#include "jit_core.h"
+#include "predecoded_core.h"
+#include "scheduler.h"
+
+const unsigned int FLEET_FRAMES_PER_SLICE = 60;  // frames per stolen task
+
+// Interpreter used to step the instances
+enum CoreKind {
+  CORE_TABLE,       // Chip8::Cycle() function-pointer tables
+  CORE_PREDECODED,  // PredecodedCore threaded dispatch
+  CORE_JIT,         // JitCore x86-64 basic-block recompiler
+  CORE_AOT,         // AotCore code built from `--recompile` output
+};
+
+const CoreKind ALL_CORES[] = {CORE_TABLE, CORE_PREDECODED, CORE_JIT, CORE_AOT};
+
+char const* CoreName(CoreKind core);  // "table", "predecoded", "jit", "aot"
+bool ParseCore(char const* name, CoreKind& core);  // false if unknown
+
+struct FleetStats {
+  uint64_t instructions{};  // instructions run (StepFrame's), all instances
+  uint64_t idle_skipped{};  // of those, skipped in idle loops (see Chip8)
+  uint64_t frames{};        // total frames across all instances
+  double seconds{};         // wall time of the run
+
+  double InstructionsPerSec() const;
+  double FramesPerSec() const;
+};
+
+// Runs many headless Chip8 instances on a work-stealing thread pool. Each
+// instance belongs to exactly one worker queue at a time, so workers never
+// share an instance; idle workers steal whole instances from the front of
+// other queues while owners pop from the back (cache-hot) end.
+class Fleet {
+ public:
+  Fleet(unsigned int threads, unsigned int instructions_per_frame,
+        CoreKind core = CORE_TABLE);
+
+  bool Add(char const* rom);  // one instance per call, false if ROM unreadable
+  std::size_t Size() const { return instances.size(); }
+
+  FleetStats Run(unsigned int frames);  // step every instance `frames` frames
+
+ private:
+  struct Instance {
+    Chip8 chip8;
+    std::unique_ptr<PredecodedCore> predecoded;  // CORE_PREDECODED only
+    std::unique_ptr<JitCore> jit;                // CORE_JIT only
+    std::unique_ptr<AotCore> aot;                // CORE_AOT only
+  };
+
+  struct Task {
+    std::size_t instance;
+    unsigned int frames_left;
+  };
+
+  struct WorkQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+  };
+
+  bool Pop(unsigned int worker, Task& task);
+  bool Steal(unsigned int worker, Task& task);
+  void Worker(unsigned int worker, uint64_t& instructions);
+  unsigned int StepFrame(Instance& instance);  // instructions run
+
+  unsigned int thread_count;
+  unsigned int instructions_per_frame;
+  CoreKind core;
+  std::atomic<std::size_t> unfinished{};  // instances with frames left
+
+  std::vector<std::unique_ptr<Instance>> instances;
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+};
+
+#endif  // CHIP8_FLEET_H
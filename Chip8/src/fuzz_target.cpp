@@ -0,0 +1,169 @@
+// Coverage-guided fuzz target (libFuzzer interface), not part of the
+// emulator build: `make fuzz` (clang, -fsanitize=fuzzer,address,undefined)
+// -> bin/linux/chip8-fuzz. Built with -DCHIP8_FUZZ_DRIVER instead, any
+// compiler gets a main() that replays input files (crash reproducers) or
+// times random inputs.
+//
+// Input: [quirk profile][ROM size, 2 bytes LE][ROM][one byte per frame:
+// bit 4 set -> key (bits 0-3) held]. With CHIP8_FUZZ_ROM=<path> in the
+// environment the ROM is fixed and the whole input is frames, so only the
+// key sequence is fuzzed.
+//
+// Feedback: besides libFuzzer's own coverage of the emulator, every guest
+// PC executed and every PC -> PC edge bumps a counter in libFuzzer's extra
+// counters section, so inputs reaching new guest code are kept too.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "chip_8.h"
+
+const unsigned int FUZZ_MAX_FRAMES = 64;  // input bytes past that: ignored
+const unsigned int FUZZ_INSTRUCTIONS_PER_FRAME = 32;
+const unsigned int FUZZ_EDGE_COUNTERS = 1u << 16u;  // power of two
+const unsigned int FUZZ_DRIVER_RUNS = 100000;       // random inputs to time
+
+#if defined(__ELF__)
+#define CHIP8_FUZZ_COUNTERS \
+  __attribute__((section("__libfuzzer_extra_counters")))
+#else
+#define CHIP8_FUZZ_COUNTERS
+#endif
+
+// libFuzzer clears these before every input
+CHIP8_FUZZ_COUNTERS static uint8_t pc_counters[ADDRESS_MASK + 1];
+CHIP8_FUZZ_COUNTERS static uint8_t edge_counters[FUZZ_EDGE_COUNTERS];
+
+// One machine for the whole session, reset from `snapshot` per input
+// instead of constructing a Chip8 (tables, fontset) every time
+static Chip8* machine;
+static Chip8State snapshot;  // power-on, or the CHIP8_FUZZ_ROM ROM loaded
+static bool fixed_rom;
+
+static void Count(uint8_t& counter) {
+  counter += counter != 0xFF;  // saturate -> hot loops stay "hot"
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+  machine = new Chip8();
+
+  char const* rom = std::getenv("CHIP8_FUZZ_ROM");
+
+  if (rom != nullptr) {
+    if (!machine->LoadRom(rom)) {
+      std::cerr << "Cannot load CHIP8_FUZZ_ROM: " << rom << "\n";
+      std::exit(EXIT_FAILURE);
+    }
+
+    fixed_rom = true;
+  }
+
+  machine->SaveState(snapshot);
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* data, std::size_t size) {
+  Chip8& c = *machine;
+
+  c.LoadState(snapshot);
+
+  if (!fixed_rom) {
+    if (size < 3) {
+      return 0;
+    }
+
+    c.SetQuirks(ALL_QUIRK_PROFILES[data[0] % 4]);
+
+    // Same bound as LoadRom: whatever doesn't fit is not loaded
+    std::size_t rom_size = std::min<std::size_t>(
+        {std::size_t{data[1]} | std::size_t{data[2]} << 8u, size - 3,
+         MAX_ROM_SIZE});
+
+    std::memcpy(&c.memory8_4kb[START_ADDRESS], data + 3, rom_size);
+    data += 3 + rom_size;
+    size -= 3 + rom_size;
+  }
+
+  uint16_t previous = c.pc16;
+
+  for (std::size_t frame = 0; frame < size && frame < FUZZ_MAX_FRAMES;
+       ++frame) {
+    std::memset(c.keypad8_16, 0, sizeof(c.keypad8_16));
+
+    if (data[frame] & 0x10u) {
+      c.keypad8_16[data[frame] & KEY_MASK] = 1;
+    }
+
+    for (unsigned int i = 0; i < FUZZ_INSTRUCTIONS_PER_FRAME && !c.Halted();
+         ++i) {
+      uint16_t pc = c.pc16 & ADDRESS_MASK;
+
+      Count(pc_counters[pc]);
+      Count(edge_counters[((previous << 4u) ^ pc) & (FUZZ_EDGE_COUNTERS - 1)]);
+      previous = pc;
+
+      c.Cycle();
+    }
+
+    c.TickTimers();
+  }
+
+  return 0;
+}
+
+#if CHIP8_FUZZ_DRIVER
+// Without libFuzzer: replay each file given, or time random inputs
+int main(int argc, char** argv) {
+  LLVMFuzzerInitialize(&argc, &argv);
+
+  if (argc > 1) {
+    for (int arg = 1; arg < argc; ++arg) {
+      std::ifstream file(argv[arg], std::ios::binary);
+      std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+      std::cout << "ok: " << argv[arg] << "\n";
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  std::mt19937 random(1);
+  std::vector<uint8_t> input;
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int run = 0; run < FUZZ_DRIVER_RUNS; ++run) {
+    input.resize(3 + random() % 512);
+
+    for (uint8_t& byte : input) {
+      byte = static_cast<uint8_t>(random());
+    }
+
+    // Leave some bytes for frames
+    std::size_t rom_size = random() % (input.size() - 2);
+    input[1] = rom_size & 0xFFu;
+    input[2] = rom_size >> 8u;
+
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::cout << "execs:     " << FUZZ_DRIVER_RUNS << "\n"
+            << "execs/sec: " << FUZZ_DRIVER_RUNS / seconds << "\n";
+
+  return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,160 @@
+#include "input_log.h"
+
+#include <cstring>
+#include <iterator>
+
+static char const INPUT_LOG_MAGIC[4] = {'C', '8', 'I', 'N'};
+const std::streamoff FRAMES_OFFSET = 4 + 4 + 8 + 4;  // where `frames` lives
+
+static void PutLe(std::ofstream& out, uint64_t value, unsigned int bytes) {
+  for (unsigned int i = 0; i < bytes; ++i) {
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFFu));
+  }
+}
+
+static uint64_t GetLe(uint8_t const* in, unsigned int bytes) {
+  uint64_t value = 0;
+
+  for (unsigned int i = 0; i < bytes; ++i) {
+    value |= uint64_t{in[i]} << (8 * i);
+  }
+
+  return value;
+}
+
+static uint16_t KeyMask(uint8_t const* keypad) {
+  uint16_t mask = 0;
+
+  for (unsigned int key = 0; key < 16; ++key) {
+    mask |= (keypad[key] ? 1u : 0u) << key;
+  }
+
+  return mask;
+}
+
+bool InputRecorder::Open(char const* file, uint64_t seed, unsigned int ipf) {
+  out.open(file, std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open()) {
+    return false;
+  }
+
+  frames = 0;
+  last_event_frame = 0;
+  last_mask = 0;
+
+  out.write(INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+  PutLe(out, INPUT_LOG_VERSION, 4);
+  PutLe(out, seed, 8);
+  PutLe(out, ipf, 4);
+  PutLe(out, 0, 8);  // frame count, filled in by Close()
+
+  return static_cast<bool>(out);
+}
+
+void InputRecorder::Frame(uint8_t const* keypad) {
+  uint16_t mask = KeyMask(keypad);
+
+  if (mask != last_mask) {
+    // LEB128 frame delta -> a change per second costs ~3 bytes
+    uint64_t delta = frames - last_event_frame;
+
+    do {
+      uint8_t byte = delta & 0x7Fu;
+      delta >>= 7u;
+      out.put(static_cast<char>(byte | (delta ? 0x80u : 0u)));
+    } while (delta);
+
+    PutLe(out, mask, 2);
+
+    last_event_frame = frames;
+    last_mask = mask;
+  }
+
+  ++frames;
+}
+
+bool InputRecorder::Close() {
+  if (!out.is_open()) {
+    return false;
+  }
+
+  out.seekp(FRAMES_OFFSET);
+  PutLe(out, frames, 8);
+  out.close();
+
+  return !out.fail();
+}
+
+bool InputReplay::Open(char const* file) {
+  std::ifstream in(file, std::ios::binary);
+
+  if (!in.is_open()) {
+    return false;
+  }
+
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+
+  if (data.size() < FRAMES_OFFSET + 8 ||
+      std::memcmp(data.data(), INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC)) !=
+          0 ||
+      GetLe(&data[4], 4) != INPUT_LOG_VERSION) {
+    return false;
+  }
+
+  seed = GetLe(&data[8], 8);
+  ipf = static_cast<unsigned int>(GetLe(&data[16], 4));
+  frames = GetLe(&data[FRAMES_OFFSET], 8);
+
+  events.clear();
+  next_event = 0;
+  frame = 0;
+
+  std::size_t pos = FRAMES_OFFSET + 8;
+  uint64_t event_frame = 0;
+
+  while (pos < data.size()) {
+    uint64_t delta = 0;
+    unsigned int shift = 0;
+    uint8_t byte;
+
+    do {
+      if (pos >= data.size() || shift > 63) {
+        return false;
+      }
+
+      byte = data[pos++];
+      delta |= uint64_t{byte & 0x7Fu} << shift;
+      shift += 7;
+    } while (byte & 0x80u);
+
+    if (pos + 2 > data.size()) {
+      return false;
+    }
+
+    event_frame += delta;
+    uint16_t mask = static_cast<uint16_t>(GetLe(&data[pos], 2));
+    events.push_back({event_frame, mask});
+    pos += 2;
+  }
+
+  return true;
+}
+
+bool InputReplay::Next(uint8_t* keypad) {
+  if (frame >= frames) {
+    return false;
+  }
+
+  while (next_event < events.size() && events[next_event].frame <= frame) {
+    uint16_t mask = events[next_event++].mask;
+
+    for (unsigned int key = 0; key < 16; ++key) {
+      keypad[key] = (mask >> key) & 1u;
+    }
+  }
+
+  ++frame;
+  return true;
+}
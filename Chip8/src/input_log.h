@@ -0,0 +1,61 @@
+#ifndef CHIP8_INPUT_LOG_H
+
+#define CHIP8_INPUT_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+const uint32_t INPUT_LOG_VERSION = 1;
+
+// Input log file (little-endian):
+//   "C8IN", u32 version, u64 RNG seed, u32 IPF, u64 frame count
+//   then one event per keypad change: LEB128 frames since the previous
+//   event, u16 key mask (bit k = key k down) in effect from that frame on
+// A run is reproduced by the same ROM + seed + IPF + events.
+
+// Writes a log while a session runs; call Frame() before every frame
+class InputRecorder {
+ public:
+  bool Open(char const* file, uint64_t seed, unsigned int ipf);
+  void Frame(uint8_t const* keypad);  // keypad8_16 as the frame will see it
+  bool Close();                       // patches the frame count in
+
+  bool IsOpen() const { return out.is_open(); }
+
+ private:
+  std::ofstream out;
+  uint64_t frames{};
+  uint64_t last_event_frame{};
+  uint16_t last_mask{};  // keypad starts all up
+};
+
+// Loads a whole log; Next() feeds it back one frame at a time
+class InputReplay {
+ public:
+  bool Open(char const* file);  // false if missing, truncated or other version
+
+  uint64_t Seed() const { return seed; }
+  unsigned int InstructionsPerFrame() const { return ipf; }
+  uint64_t Frames() const { return frames; }
+
+  // Keypad for the next frame; false once every logged frame was replayed
+  bool Next(uint8_t* keypad);
+
+ private:
+  struct Event {
+    uint64_t frame;
+    uint16_t mask;
+  };
+
+  uint64_t seed{};
+  unsigned int ipf{};
+  uint64_t frames{};
+
+  std::vector<Event> events;
+  std::size_t next_event{};
+  uint64_t frame{};
+};
+
+#endif  // CHIP8_INPUT_LOG_H
@@ -0,0 +1,646 @@
+#include "jit_core.h"
+
+#include <cstring>
+
+#if CHIP8_JIT_SUPPORTED
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8::memory8_4kb);
+
+// Longest code one CHIP-8 instruction can emit, plus the block epilogue
+const std::size_t JIT_MAX_INSTRUCTION_BYTES = 64;
+
+namespace {
+
+// Just enough of an x86-64 assembler for the blocks. Inside generated code:
+// rbx = Chip8* (members addressed as [rbx + disp32]), r12 = JitCore*,
+// r13d = instruction budget left, r14 = entry table (one pointer per PC).
+class X64Emitter {
+ public:
+  explicit X64Emitter(uint8_t* out) : out(out) {}
+
+  std::size_t Size() const { return at; }
+
+  void Byte(uint8_t b) { out[at++] = b; }
+
+  void Word(uint16_t w) {
+    Byte(w & 0xFFu);
+    Byte(w >> 8u);
+  }
+
+  void Dword(uint32_t d) {
+    for (int i = 0; i < 4; ++i) {
+      Byte((d >> (8 * i)) & 0xFFu);
+    }
+  }
+
+  // opcode bytes, then ModRM [rbx + disp32] with `reg` in the reg field
+  void RbxMem(uint8_t reg, int32_t disp) {
+    Byte(0x80u | (reg << 3u) | 0x3u);
+    Dword(static_cast<uint32_t>(disp));
+  }
+
+  // [rbx + index*scale + disp32], index = rax
+  void RbxRaxMem(uint8_t reg, uint8_t scale_bits, int32_t disp) {
+    Byte(0x84u | (reg << 3u));
+    Byte((scale_bits << 6u) | (0x0u << 3u) | 0x3u);
+    Dword(static_cast<uint32_t>(disp));
+  }
+
+  // Patchable forward jcc rel8: returns the offset of the rel8 byte
+  std::size_t JccShort(uint8_t cc) {
+    Byte(0x70u | cc);
+    Byte(0);
+    return at - 1;
+  }
+
+  void Bind(std::size_t rel8_at) {
+    out[rel8_at] = static_cast<uint8_t>(at - (rel8_at + 1));
+  }
+
+  void CallHelper(void const* helper, uint32_t opcode) {
+#if defined(_WIN32)
+    Byte(0x4C), Byte(0x89), Byte(0xE1);  // mov rcx, r12
+    Byte(0xBA), Dword(opcode);           // mov edx, opcode
+#else
+    Byte(0x4C), Byte(0x89), Byte(0xE7);  // mov rdi, r12
+    Byte(0xBE), Dword(opcode);           // mov esi, opcode
+#endif
+    uint64_t address = reinterpret_cast<uint64_t>(helper);
+    Byte(0x48), Byte(0xB8);  // mov rax, imm64
+    Dword(address & 0xFFFFFFFFu);
+    Dword(address >> 32u);
+    Byte(0xFF), Byte(0xD0);  // call rax
+  }
+
+  uint8_t* Here() const { return out + at; }
+
+  // rel32 operand of a jmp/jcc that ends here, aimed at `target`
+  void Rel32(uint8_t const* target) {
+    Dword(static_cast<uint32_t>(target - (Here() + 4)));
+  }
+
+ private:
+  uint8_t* out;
+  std::size_t at{};
+};
+
+// x86 condition codes for JccShort
+const uint8_t CC_E = 0x4;
+const uint8_t CC_NE = 0x5;
+
+// Register numbers for the ModRM reg field
+const uint8_t AL = 0;
+const uint8_t CL = 1;
+const uint8_t DL = 2;
+
+}  // namespace
+
+JitCore::JitCore(Chip8& chip8) : chip8(chip8) {
+#if CHIP8_JIT_SUPPORTED
+#if defined(_WIN32)
+  code_buffer = static_cast<uint8_t*>(
+      VirtualAlloc(nullptr, JIT_CODE_BUFFER_SIZE, MEM_COMMIT | MEM_RESERVE,
+                   PAGE_EXECUTE_READWRITE));
+#else
+  void* mapping = mmap(nullptr, JIT_CODE_BUFFER_SIZE,
+                       PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  code_buffer = mapping == MAP_FAILED ? nullptr
+                                      : static_cast<uint8_t*>(mapping);
+#endif
+#endif
+
+  Flush();
+  cache_flushes = 0;
+}
+
+JitCore::~JitCore() {
+#if CHIP8_JIT_SUPPORTED
+  if (code_buffer != nullptr) {
+#if defined(_WIN32)
+    VirtualFree(code_buffer, 0, MEM_RELEASE);
+#else
+    munmap(code_buffer, JIT_CODE_BUFFER_SIZE);
+#endif
+  }
+#endif
+}
+
+void JitCore::Invalidate() { Flush(); }
+
+void JitCore::Flush() {
+  blocks.clear();
+  code_used = 0;
+
+  for (unsigned int a = 0; a < MEMORY_SIZE; ++a) {
+    code_bytes[a] = 0;
+  }
+
+  if (code_buffer != nullptr) {
+    EmitTrampoline();
+  }
+
+  for (unsigned int a = 0; a < MEMORY_SIZE; ++a) {
+    entry[a] = exit_stub;  // not compiled -> back to Run()
+  }
+
+  ++cache_flushes;
+}
+
+void JitCore::EmitTrampoline() {
+  int32_t const PC = static_cast<int32_t>(
+      reinterpret_cast<uint8_t*>(&chip8.pc16) -
+      reinterpret_cast<uint8_t*>(&chip8));
+
+  X64Emitter x(code_buffer);
+
+  // uint32_t enter(Chip8*, JitCore*, void* const* entries, uint32_t budget)
+  x.Byte(0x53);                // push rbx
+  x.Byte(0x41), x.Byte(0x54);  // push r12
+  x.Byte(0x41), x.Byte(0x55);  // push r13
+  x.Byte(0x41), x.Byte(0x56);  // push r14
+#if defined(_WIN32)
+  x.Byte(0x48), x.Byte(0x83), x.Byte(0xEC), x.Byte(40);  // sub rsp, 40
+  x.Byte(0x48), x.Byte(0x89), x.Byte(0xCB);  // mov rbx, rcx
+  x.Byte(0x49), x.Byte(0x89), x.Byte(0xD4);  // mov r12, rdx
+  x.Byte(0x4D), x.Byte(0x89), x.Byte(0xC6);  // mov r14, r8
+  x.Byte(0x45), x.Byte(0x89), x.Byte(0xCD);  // mov r13d, r9d
+#else
+  x.Byte(0x48), x.Byte(0x83), x.Byte(0xEC), x.Byte(8);  // sub rsp, 8
+  x.Byte(0x48), x.Byte(0x89), x.Byte(0xFB);  // mov rbx, rdi
+  x.Byte(0x49), x.Byte(0x89), x.Byte(0xF4);  // mov r12, rsi
+  x.Byte(0x49), x.Byte(0x89), x.Byte(0xD6);  // mov r14, rdx
+  x.Byte(0x41), x.Byte(0x89), x.Byte(0xCD);  // mov r13d, ecx
+#endif
+
+  // Shared tail of every block: jump to the block for the current PC
+  dispatch_stub = x.Here();
+  x.Byte(0x0F), x.Byte(0xB7), x.RbxMem(AL, PC);  // movzx eax, word [PC]
+  x.Byte(0x3D), x.Dword(MEMORY_SIZE - 2);        // cmp eax, 0xFFE
+  x.Byte(0x0F), x.Byte(0x87);                    // ja exit
+  std::size_t ja_at = x.Size();
+  x.Dword(0);
+  x.Byte(0x41), x.Byte(0xFF), x.Byte(0x24), x.Byte(0xC6);  // jmp [r14+rax*8]
+
+  exit_stub = x.Here();
+  x.Byte(0x44), x.Byte(0x89), x.Byte(0xE8);  // mov eax, r13d
+#if defined(_WIN32)
+  x.Byte(0x48), x.Byte(0x83), x.Byte(0xC4), x.Byte(40);  // add rsp, 40
+#else
+  x.Byte(0x48), x.Byte(0x83), x.Byte(0xC4), x.Byte(8);  // add rsp, 8
+#endif
+  x.Byte(0x41), x.Byte(0x5E);  // pop r14
+  x.Byte(0x41), x.Byte(0x5D);  // pop r13
+  x.Byte(0x41), x.Byte(0x5C);  // pop r12
+  x.Byte(0x5B);                // pop rbx
+  x.Byte(0xC3);                // ret
+
+  uint32_t ja_rel =
+      static_cast<uint32_t>(exit_stub - (code_buffer + ja_at + 4));
+  std::memcpy(code_buffer + ja_at, &ja_rel, sizeof(ja_rel));
+
+  enter = reinterpret_cast<EnterFunc>(code_buffer);
+  code_used = x.Size();
+}
+
+unsigned int JitCore::StepFrame(unsigned int instructions) {
+  unsigned int ran = Run(instructions);
+  chip8.TickTimers();
+  return ran;
+}
+
+unsigned int JitCore::Run(unsigned int instructions) {
+  unsigned int due = instructions;
+
+  while (instructions > 0 && !chip8.Halted()) {
+    uint16_t pc = chip8.pc16;
+
+    if (code_buffer == nullptr || pc >= MEMORY_SIZE - 1) {
+      // No JIT on this host, or PC at the last byte -> interpreter
+      InterpretOne();
+      --instructions;
+      continue;
+    }
+
+    if (entry[pc] == exit_stub) {
+      Compile(pc);
+    }
+
+    // Chained blocks run until one isn't compiled or doesn't fit the budget
+    uint32_t left = enter(&chip8, this, entry, instructions);
+
+    native_instructions += instructions - left;
+
+    uint16_t stopped_at = chip8.pc16;
+
+    if (left == instructions && stopped_at < MEMORY_SIZE - 1 &&
+        entry[stopped_at] != exit_stub) {
+      // Budget smaller than the next block -> finish the frame one
+      // instruction at a time
+      InterpretOne();
+      --left;
+    }
+
+    instructions = left;
+  }
+
+  return due - instructions;  // only a halt leaves some
+}
+
+void JitCore::InterpretOne() {
+  uint16_t index = chip8.index16;
+
+  chip8.Cycle();
+  ++interpreted_instructions;
+
+  uint16_t opcode = chip8.opcode16;
+
+  if ((opcode & 0xF0FFu) == 0xF033u) {
+    OnWrite(index, 3);
+  } else if ((opcode & 0xF0FFu) == 0xF055u) {
+    OnWrite(index, ((opcode & 0x0F00u) >> 8u) + 1u);
+  }
+}
+
+void JitCore::Fallback(JitCore* self, uint32_t opcode) {
+  Chip8& c = self->chip8;
+
+  c.opcode16 = static_cast<uint16_t>(opcode);
+  ((c).*(c.table[(opcode & 0xF000u) >> 12u]))();
+}
+
+void JitCore::Store(JitCore* self, uint32_t opcode) {
+  uint16_t index = self->chip8.index16;
+
+  Fallback(self, opcode);
+
+  if ((opcode & 0x00FFu) == 0x33u) {
+    self->OnWrite(index, 3);
+  } else {
+    self->OnWrite(index, ((opcode & 0x0F00u) >> 8u) + 1u);
+  }
+}
+
+void JitCore::OnWrite(uint16_t address, unsigned int length) {
+  // Stores wrap at 4 KB -> the part past 0xFFF is a store at 0
+  address &= ADDRESS_MASK;
+
+  if (address + length > MEMORY_SIZE) {
+    unsigned int head = MEMORY_SIZE - address;
+
+    OnWrite(0, length - head);
+    length = head;
+  }
+
+  bool hits_code = false;
+
+  for (unsigned int a = address; a < address + length && a < MEMORY_SIZE;
+       ++a) {
+    hits_code = hits_code || code_bytes[a] > 0;
+  }
+
+  if (!hits_code) {
+    return;
+  }
+
+  // Drop (but don't free) every block that read one of the written bytes;
+  // the block that did the store may still be running its epilogue
+  for (Block& block : blocks) {
+    if (block.count == 0 || block.end <= address ||
+        block.start >= address + length) {
+      continue;
+    }
+
+    for (unsigned int a = block.start; a < block.end; ++a) {
+      --code_bytes[a];
+    }
+
+    entry[block.start] = exit_stub;  // chained jumps now land in Run()
+    block.count = 0;
+  }
+}
+
+void JitCore::Compile(uint16_t pc) {
+  std::size_t worst_case =
+      JIT_MAX_BLOCK_INSTRUCTIONS * JIT_MAX_INSTRUCTION_BYTES + 64;
+
+  // The bump allocator never reuses code -> refill from empty when full
+
+  if (code_used + worst_case > JIT_CODE_BUFFER_SIZE) {
+    Flush();  // only called between blocks -> nothing is running
+  }
+
+  // Offsets of the members from the Chip8 object, as disp32
+  uint8_t* base = reinterpret_cast<uint8_t*>(&chip8);
+  auto offset = [base](void const* member) {
+    return static_cast<int32_t>(static_cast<uint8_t const*>(member) - base);
+  };
+
+  int32_t const V = offset(chip8.registers8_16);
+  int32_t const VF = V + 0xF;
+  int32_t const I = offset(&chip8.index16);
+  int32_t const PC = offset(&chip8.pc16);
+  int32_t const STACK = offset(chip8.stack16_16);
+  int32_t const SP = offset(&chip8.sp8);
+  int32_t const DT = offset(&chip8.delay_timer8);
+  int32_t const ST = offset(&chip8.sound_timer8);
+  int32_t const KEYS = offset(chip8.keypad8_16);
+  int32_t const OPCODE = offset(&chip8.opcode16);
+
+  void const* fallback = reinterpret_cast<void const*>(&JitCore::Fallback);
+  void const* store = reinterpret_cast<void const*>(&JitCore::Store);
+
+  // Quirks are picked here, not at run time: a block bakes in the profile
+  // it was compiled under (Dxyn, Fx55, Fx65 follow it through the tables)
+  bool shift_vy = false;
+  bool jump_vx = false;
+  bool logic_resets_vf = false;
+
+  WithQuirks(chip8.Quirks(), [&](auto policy) {
+    shift_vy = decltype(policy)::SHIFT_VY;
+    jump_vx = decltype(policy)::JUMP_VX;
+    logic_resets_vf = decltype(policy)::LOGIC_RESETS_VF;
+  });
+
+  X64Emitter x(code_buffer + code_used);
+
+  // Budget check: cmp r13d, count / jb exit / sub r13d, count (patched)
+  x.Byte(0x41), x.Byte(0x81), x.Byte(0xFD);
+  std::size_t count_at_cmp = x.Size();
+  x.Dword(0);
+  x.Byte(0x0F), x.Byte(0x82), x.Rel32(exit_stub);
+  x.Byte(0x41), x.Byte(0x81), x.Byte(0xED);
+  std::size_t count_at_sub = x.Size();
+  x.Dword(0);
+
+  uint16_t address = pc;
+  uint16_t count = 0;
+  uint16_t opcode = 0;
+  bool ended = false;
+  int32_t static_target = -1;  // next PC when known at compile time
+  bool to_run = false;  // leave for Run() -> it sees a halt
+
+  while (!ended) {
+    if (count == JIT_MAX_BLOCK_INSTRUCTIONS || address >= MEMORY_SIZE - 1) {
+      // Fall through into whatever comes next
+      x.Byte(0x66), x.Byte(0xC7), x.RbxMem(0, PC), x.Word(address);
+      static_target = address;
+      break;
+    }
+
+    opcode = (chip8.memory8_4kb[address] << 8u) |
+             chip8.memory8_4kb[address + 1];
+
+    uint8_t vx = (opcode & 0x0F00u) >> 8u;
+    uint8_t vy = (opcode & 0x00F0u) >> 4u;
+    uint8_t nn = opcode & 0x00FFu;
+    uint16_t nnn = opcode & 0x0FFFu;
+    uint16_t next = address + 2;
+
+    ++count;
+    address = next;
+
+    // mov word [PC], imm16
+    auto set_pc = [&](uint16_t value) {
+      x.Byte(0x66), x.Byte(0xC7), x.RbxMem(0, PC), x.Word(value);
+    };
+
+    // PC = next, or next + 2 when the flags match `skip_if` (mov keeps them)
+    auto skip = [&](uint8_t skip_if) {
+      set_pc(next);
+      std::size_t over = x.JccShort(skip_if ^ 1u);
+      set_pc(next + 2);
+      x.Bind(over);
+      ended = true;
+    };
+
+    switch ((opcode & 0xF000u) >> 12u) {
+      case 0x0:
+        if ((opcode & 0x000Fu) == 0xE) {  // 00EE RET
+          x.Byte(0xFE), x.RbxMem(1, SP);                 // dec byte [SP]
+          x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, SP);  // movzx eax, [SP]
+          x.Byte(0x83), x.Byte(0xE0), x.Byte(STACK_MASK);  // and eax, 0xF
+          x.Byte(0x0F), x.Byte(0xB7), x.RbxRaxMem(AL, 1, STACK);
+          x.Byte(0x66), x.Byte(0x89), x.RbxMem(AL, PC);  // mov [PC], ax
+          ended = true;
+        } else if ((opcode & 0x000Fu) == 0x0) {  // 00E0 CLS (and 0nn0)
+          x.CallHelper(fallback, opcode);
+        }
+        break;
+
+      case 0x1:  // JP nnn
+        set_pc(nnn);
+        static_target = nnn;
+        ended = true;
+        break;
+
+      case 0x2:  // CALL nnn
+        x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, SP);  // movzx eax, [SP]
+        x.Byte(0x83), x.Byte(0xE0), x.Byte(STACK_MASK);  // and eax, 0xF
+        x.Byte(0x66), x.Byte(0xC7), x.RbxRaxMem(0, 1, STACK), x.Word(next);
+        x.Byte(0xFE), x.RbxMem(0, SP);  // inc byte [SP]
+        set_pc(nnn);
+        static_target = nnn;
+        ended = true;
+        break;
+
+      case 0x3:  // SE Vx, nn
+      case 0x4:  // SNE Vx, nn
+        x.Byte(0x80), x.RbxMem(7, V + vx), x.Byte(nn);  // cmp [Vx], nn
+        skip(((opcode & 0xF000u) == 0x3000u) ? CC_E : CC_NE);
+        break;
+
+      case 0x5:  // SE Vx, Vy
+      case 0x9:  // SNE Vx, Vy
+        x.Byte(0x8A), x.RbxMem(AL, V + vx);  // mov al, [Vx]
+        x.Byte(0x3A), x.RbxMem(AL, V + vy);  // cmp al, [Vy]
+        skip(((opcode & 0xF000u) == 0x5000u) ? CC_E : CC_NE);
+        break;
+
+      case 0x6:  // LD Vx, nn
+        x.Byte(0xC6), x.RbxMem(0, V + vx), x.Byte(nn);
+        break;
+
+      case 0x7:  // ADD Vx, nn
+        x.Byte(0x80), x.RbxMem(0, V + vx), x.Byte(nn);
+        break;
+
+      case 0x8:
+        // Same load/store order as Chip8::Op_8xy* so x or y == F matches
+        switch (opcode & 0x000Fu) {
+          case 0x0:
+            x.Byte(0x8A), x.RbxMem(AL, V + vy);
+            x.Byte(0x88), x.RbxMem(AL, V + vx);
+            break;
+
+          case 0x1:
+          case 0x2:
+          case 0x3: {
+            uint8_t const alu[] = {0, 0x08, 0x20, 0x30};  // or / and / xor
+            x.Byte(0x8A), x.RbxMem(AL, V + vy);
+            x.Byte(alu[opcode & 0x000Fu]), x.RbxMem(AL, V + vx);
+
+            if (logic_resets_vf) {
+              x.Byte(0xC6), x.RbxMem(0, VF), x.Byte(0);  // mov [VF], 0
+            }
+          } break;
+
+          case 0x4:
+            x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, V + vx);  // movzx eax
+            x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(CL, V + vy);  // movzx ecx
+            x.Byte(0x01), x.Byte(0xC8);                    // add eax, ecx
+            x.Byte(0x3D), x.Dword(255);                    // cmp eax, 255
+            x.Byte(0x0F), x.Byte(0x97), x.Byte(0xC2);      // seta dl
+            x.Byte(0x88), x.RbxMem(DL, VF);                // mov [VF], dl
+            x.Byte(0x88), x.RbxMem(AL, V + vx);            // mov [Vx], al
+            break;
+
+          case 0x5:
+          case 0x7: {
+            bool reverse = (opcode & 0x000Fu) == 0x7;  // 8xy7: Vy - Vx
+            int32_t lhs = V + (reverse ? vy : vx);
+            int32_t rhs = V + (reverse ? vx : vy);
+            x.Byte(0x8A), x.RbxMem(AL, lhs);           // mov al, [lhs]
+            x.Byte(0x3A), x.RbxMem(AL, rhs);           // cmp al, [rhs]
+            x.Byte(0x0F), x.Byte(0x97), x.Byte(0xC2);  // seta dl
+            x.Byte(0x88), x.RbxMem(DL, VF);            // mov [VF], dl
+            x.Byte(0x8A), x.RbxMem(AL, lhs);           // reload after VF
+            x.Byte(0x2A), x.RbxMem(AL, rhs);           // sub al, [rhs]
+            x.Byte(0x88), x.RbxMem(AL, V + vx);        // mov [Vx], al
+          } break;
+
+          case 0x6:
+          case 0xE: {
+            bool left = (opcode & 0x000Fu) == 0xE;
+            int32_t source = V + (shift_vy ? vy : vx);
+            x.Byte(0x8A), x.RbxMem(AL, source);        // mov al, [src]
+
+            if (left) {
+              x.Byte(0xC0), x.Byte(0xE8), x.Byte(7);   // shr al, 7
+            } else {
+              x.Byte(0x24), x.Byte(0x01);              // and al, 1
+            }
+
+            x.Byte(0x88), x.RbxMem(AL, VF);            // mov [VF], al
+
+            if (shift_vy) {
+              x.Byte(0x8A), x.RbxMem(AL, source);      // reload after VF
+              x.Byte(0xD0), x.Byte(left ? 0xE0 : 0xE8);  // shl/shr al, 1
+              x.Byte(0x88), x.RbxMem(AL, V + vx);      // mov [Vx], al
+            } else {
+              x.Byte(0xD0), x.RbxMem(left ? 4 : 5, V + vx);  // shl/shr [Vx]
+            }
+          } break;
+        }
+        break;
+
+      case 0xA:  // LD I, nnn
+        x.Byte(0x66), x.Byte(0xC7), x.RbxMem(0, I), x.Word(nnn);
+        break;
+
+      case 0xB:  // JP V0, nnn (JUMP_VX: JP Vx, xnn)
+        x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, V + (jump_vx ? vx : 0));
+        x.Byte(0x05), x.Dword(nnn);                   // add eax, nnn
+        x.Byte(0x66), x.Byte(0x89), x.RbxMem(AL, PC);  // mov [PC], ax
+        ended = true;
+        break;
+
+      case 0xC:  // RND, DRW -> Chip8 (RNG stream, framebuffer)
+      case 0xD:
+        x.CallHelper(fallback, opcode);
+        break;
+
+      case 0xE:
+        if ((opcode & 0x000Fu) == 0xE || (opcode & 0x000Fu) == 0x1) {
+          x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, V + vx);  // movzx eax
+          x.Byte(0x83), x.Byte(0xE0), x.Byte(KEY_MASK);      // and eax, 0xF
+          x.Byte(0x80), x.RbxRaxMem(7, 0, KEYS), x.Byte(0);  // cmp [key], 0
+          skip(((opcode & 0x000Fu) == 0xE) ? CC_NE : CC_E);
+        }
+        break;
+
+      case 0xF:
+        switch (opcode & 0x00FFu) {
+          case 0x07:
+            x.Byte(0x8A), x.RbxMem(AL, DT);
+            x.Byte(0x88), x.RbxMem(AL, V + vx);
+            break;
+
+          case 0x0A:  // wait for key: Op_Fx0A rewinds PC and halts itself
+            set_pc(next);
+            x.CallHelper(fallback, opcode);
+            to_run = true;
+            ended = true;
+            break;
+
+          case 0x15:
+          case 0x18:
+            x.Byte(0x8A), x.RbxMem(AL, V + vx);
+            x.Byte(0x88), x.RbxMem(AL, (opcode & 0x00FFu) == 0x15 ? DT : ST);
+            break;
+
+          case 0x1E:
+            x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, V + vx);  // movzx eax
+            x.Byte(0x66), x.Byte(0x01), x.RbxMem(AL, I);       // add [I], ax
+            break;
+
+          case 0x29:
+            x.Byte(0x0F), x.Byte(0xB6), x.RbxMem(AL, V + vx);  // movzx eax
+            x.Byte(0x8D), x.Byte(0x44), x.Byte(0x80);          // lea eax,
+            x.Byte(FONTSET_START_ADDRESS);                     // [5*rax+50]
+            x.Byte(0x66), x.Byte(0x89), x.RbxMem(AL, I);       // mov [I], ax
+            break;
+
+          case 0x33:  // may store into code -> end the block
+          case 0x55:
+            set_pc(next);
+            x.CallHelper(store, opcode);
+            ended = true;
+            break;
+
+          case 0x65:
+            x.CallHelper(fallback, opcode);
+            break;
+        }
+        break;
+    }
+  }
+
+  // Chip8::Cycle() leaves the last opcode behind; so does a block
+  x.Byte(0x66), x.Byte(0xC7), x.RbxMem(0, OPCODE), x.Word(opcode);
+
+  if (to_run) {
+    x.Byte(0xE9), x.Rel32(exit_stub);
+  } else if (static_target >= 0 &&
+             static_target < static_cast<int32_t>(MEMORY_SIZE - 1)) {
+    // jmp [r14 + target*8] -> chain straight into the next block
+    x.Byte(0x41), x.Byte(0xFF), x.Byte(0xA6), x.Dword(static_target * 8);
+  } else {
+    x.Byte(0xE9), x.Rel32(dispatch_stub);  // PC only known at run time
+  }
+
+  uint32_t count32 = count;
+  std::memcpy(code_buffer + code_used + count_at_cmp, &count32, 4);
+  std::memcpy(code_buffer + code_used + count_at_sub, &count32, 4);
+
+  Block block;
+  block.start = pc;
+  block.end = address;
+  block.count = count;
+
+  entry[pc] = code_buffer + code_used;
+  code_used += x.Size();
+
+  for (unsigned int a = block.start; a < block.end; ++a) {
+    ++code_bytes[a];
+  }
+
+  blocks.push_back(block);
+  ++blocks_compiled;
+}
@@ -0,0 +1,96 @@
+#ifndef CHIP8_JIT_CORE_H
+
+#define CHIP8_JIT_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chip_8.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHIP8_JIT_SUPPORTED 1
+#else
+#define CHIP8_JIT_SUPPORTED 0
+#endif
+
+const unsigned int JIT_MAX_BLOCK_INSTRUCTIONS = 64;
+const std::size_t JIT_CODE_BUFFER_SIZE = 256 * 1024;  // per instance
+
+// Dynamic recompiler: translates CHIP-8 basic blocks into x86-64 code that
+// works directly on the Chip8's members. Blocks end at 1nnn/2nnn/00EE/Bnnn,
+// at skips and at Fx0A (and after Fx33/Fx55, which may rewrite code).
+// Dxyn, Cxnn, 00E0, Fx0A and the memory ops call back into Chip8::Op_*.
+//
+// Blocks are cached by start PC in a per-PC entry table and jump straight to
+// each other through it, so control only returns to Run() for uncompiled
+// code. Blocks are dropped when Fx33/Fx55 store into their bytes. A block
+// only runs when the frame budget covers all of it; the tail of a frame is
+// interpreted by Chip8::Cycle(), so StepFrame(n) still runs exactly n
+// instructions and ends in the interpreter's state. On non-x86-64 builds
+// every instruction goes through Chip8::Cycle().
+//
+// Anything that writes `memory8_4kb` behind the core's back (LoadRom, a
+// restored snapshot...) or changes its Quirks() must be followed by
+// Invalidate(): blocks are compiled for one quirk profile.
+class JitCore {
+ public:
+  explicit JitCore(Chip8& chip8);
+  ~JitCore();
+
+  JitCore(JitCore const&) = delete;
+  JitCore& operator=(JitCore const&) = delete;
+
+  // Same effect as N Cycle(); returns how many ran, as Chip8::StepFrame()
+  unsigned int Run(unsigned int instructions);
+  unsigned int StepFrame(unsigned int instructions);  // Chip8::StepFrame()
+
+  void Invalidate();  // drop every compiled block
+
+  uint64_t BlocksCompiled() const { return blocks_compiled; }
+  uint64_t CacheFlushes() const { return cache_flushes; }
+  uint64_t NativeInstructions() const { return native_instructions; }
+  uint64_t InterpretedInstructions() const { return interpreted_instructions; }
+
+ private:
+  // Generated entry: runs chained blocks from chip8->pc16, returns the
+  // budget left when it hits an uncompiled PC or a block that doesn't fit
+  typedef uint32_t (*EnterFunc)(Chip8* chip8, JitCore* self,
+                                void* const* entries, uint32_t budget);
+
+  struct Block {
+    uint16_t start;  // first byte of the first instruction
+    uint16_t end;    // one past the last byte read
+    uint16_t count;  // instructions in the block (0 = dropped)
+  };
+
+  void Compile(uint16_t pc);
+  void InterpretOne();
+  void OnWrite(uint16_t address, unsigned int length);  // Fx33/Fx55 stores
+  void Flush();  // empty the cache and rewind the code buffer
+  void EmitTrampoline();
+
+  // Called from generated code (plain C calling convention)
+  static void Fallback(JitCore* self, uint32_t opcode);
+  static void Store(JitCore* self, uint32_t opcode);
+
+  Chip8& chip8;
+
+  uint8_t* code_buffer{};  // RWX, bump allocated, reset by Flush()
+  std::size_t code_used{};
+
+  EnterFunc enter{};         // start of the buffer
+  uint8_t* dispatch_stub{};  // jump to entry[pc16]
+  uint8_t* exit_stub{};      // return to Run()
+
+  std::vector<Block> blocks;
+  void* entry[sizeof(Chip8::memory8_4kb)];  // block code, or exit_stub
+  uint16_t code_bytes[sizeof(Chip8::memory8_4kb)]{};  // blocks covering byte
+
+  uint64_t blocks_compiled{};
+  uint64_t cache_flushes{};
+  uint64_t native_instructions{};
+  uint64_t interpreted_instructions{};
+};
+
+#endif  // CHIP8_JIT_CORE_H
@@ -1,18 +1,572 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "aot_compiler.h"
+#include "aot_core.h"
+#include "audio.h"
+#include "batch_core.h"
+#include "bench.h"
 #include "chip_8.h"
+#include "extended_chip_8.h"
+#include "fleet.h"
+#include "input_log.h"
+#include "pacer.h"
 #include "platform.h"
+#include "profiler.h"
+#include "rewind.h"
+#include "rom_cache.h"
+#include "scheduler.h"
+#include "triple_buffer.h"
 
-int main(int argc, char** argv) {
+// Render thread with nothing new to present sleeps until input or the next
+// frame's Wake(); this only bounds the sleep if a wake were ever lost
+const int RENDER_WAIT_TIMEOUT_MS = 100;
+
+// What the render thread's event loop hands the emulation thread; each
+// field is read once per emulated frame
+struct HostInput {
+  std::atomic<uint16_t> keys{};  // bit k: key k down
+  std::atomic<bool> rewinding{};
+  std::atomic<bool> stats_requested{};
+  std::atomic<bool> quit{};
+
+  // Emulation thread halted in Fx0A sleeps on this; woken by key changes
+  // and quit only
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+
+  void StoreKeys(uint8_t const* keypad) {
+    uint16_t mask = 0;
+
+    for (unsigned int key = 0; key < 16; ++key) {
+      mask |= uint16_t{keypad[key] != 0} << key;
+    }
+
+    if (keys.exchange(mask, std::memory_order_relaxed) != mask) {
+      Notify();
+    }
+  }
+
+  uint16_t LoadKeys(uint8_t* keypad) const {  // returns the mask loaded
+    uint16_t mask = keys.load(std::memory_order_relaxed);
+
+    for (unsigned int key = 0; key < 16; ++key) {
+      keypad[key] = (mask >> key) & 1u;
+    }
+
+    return mask;
+  }
+
+  void Quit() {
+    quit.store(true);
+    Notify();
+  }
+
+  // Until the keys differ from `seen`, quit, or `timeout` passes
+  void WaitForKeys(uint16_t seen, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+
+    wake.wait_for(lock, timeout, [this, seen] {
+      return keys.load(std::memory_order_relaxed) != seen || quit.load();
+    });
+  }
+
+ private:
+  void Notify() {
+    // Empty critical section -> a waiter between its check and its sleep
+    // can't miss this
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake.notify_one();
+  }
+};
+
+// Emulation thread of the windowed mode: runs the frames (paced, or
+// uncapped) and publishes each finished display; its only SDL call is the
+// thread-safe wake of the render thread (Platform::Wake)
+static void Emulate(Chip8& chip8, Scheduler& scheduler,
+                    InputRecorder& recorder, HostInput& input,
+                    TripleBuffer& frames, FramePacer& pacer,
+                    AudioSynth& synth, Platform& platform) {
+  RewindBuffer rewind;  // Backspace steps back (not when uncapped)
+  auto last_frame_time = std::chrono::steady_clock::now();
+
+  while (!input.quit.load(std::memory_order_relaxed)) {
+    uint16_t keys = input.LoadKeys(chip8.keypad8_16);
+
+#if CHIP8_STATS
+    if (input.stats_requested.exchange(false)) {
+      chip8.FlushStats();  // Tab -> counters so far
+      DumpStats(chip8.stats, std::cout);
+    }
+#endif
+
+    if (scheduler.Uncapped()) {
+      // CPU free-runs -> sleeps only when halted, timers follow host time
+      auto current_time = std::chrono::steady_clock::now();
+
+      // At most one frame published per 60 Hz frame
+      if (scheduler.Advance(current_time - last_frame_time) > 0) {
+        frames.Publish(chip8.video64_32);
+        platform.Wake();
+        chip8.dirty_rows32 = 0;
+      }
+
+      last_frame_time = current_time;
+
+      // Waiting in Fx0A or polling in an idle loop -> nothing to spin on;
+      // sleep until a key changes or the timers are due a tick
+      if (chip8.Halted() || scheduler.Idle()) {
+        input.WaitForKeys(keys, scheduler.UntilNextFrame());
+      }
+
+      continue;
+    }
+
+    if (input.rewinding.load(std::memory_order_relaxed) &&
+        !recorder.IsOpen()) {
+      // One recorded frame back per 60 Hz frame; the host keypad stays live
+      rewind.StepBack(chip8);
+      input.LoadKeys(chip8.keypad8_16);
+      synth.Track(false, 0, 1);  // silent while going backwards
+      synth.EndFrame(false);
+    } else {
+      // One frame of work, then sleep until the next 60 Hz deadline
+      if (recorder.IsOpen()) {
+        recorder.Frame(chip8.keypad8_16);
+      }
+
+      scheduler.RunFrame();
+      rewind.Push(chip8);
+    }
+
+    // The renderer diffs against what it last showed -> dirty_rows32 unused
+    frames.Publish(chip8.video64_32);
+    platform.Wake();
+    chip8.dirty_rows32 = 0;
+    pacer.Wait();
+  }
+
+#if CHIP8_STATS
+  chip8.FlushStats();  // counts live per thread -> collect them here
+#endif
+}
+
+// Headless fleet mode: no SDL, every ROM loaded <Copies> times and stepped on
+// a thread pool for <Frames> frames, then aggregate throughput is reported.
+int RunHeadless(int argc, char** argv) {
+  CoreKind core = CORE_TABLE;
+  int first = 2;  // first positional argument
+
+  // Optional `--core <table|predecoded|jit|aot>` right after --headless
+  if (argc > 3 && std::string(argv[2]) == "--core") {
+    if (!ParseCore(argv[3], core)) {
+      std::cerr << "Unknown core: " << argv[3] << "\n";
+      return EXIT_FAILURE;
+    }
+
+    first += 2;
+  }
+
+  if (argc < first + 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " --headless [--core table|predecoded|jit|aot] <Threads> "
+                 "<Frames> <IPF> <Copies> <ROM> [ROM...] \n";
+    return EXIT_FAILURE;
+  }
+
+  unsigned int threads = std::stoul(argv[first]);  // 0 = one per host core
+  unsigned int frames = std::stoul(argv[first + 1]);
+  unsigned int instructions_per_frame = std::stoul(argv[first + 2]);
+  unsigned int copies = std::stoul(argv[first + 3]);
+
+  // No host clock here -> a frame must carry a fixed instruction budget
+  if (instructions_per_frame == UNCAPPED) {
+    std::cerr << "Headless mode needs <IPF> > 0\n";
+    return EXIT_FAILURE;
+  }
+
+  Fleet fleet(threads, instructions_per_frame, core);
+
+  for (int arg = first + 4; arg < argc; ++arg) {
+    for (unsigned int copy = 0; copy < copies; ++copy) {
+      if (!fleet.Add(argv[arg])) {
+        std::cerr << "Cannot open ROM: " << argv[arg] << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  FleetStats stats = fleet.Run(frames);
+
+  std::cout << "instances:    " << fleet.Size() << "\n"
+            << "instructions: " << stats.instructions << "\n"
+            << "idle skipped: " << stats.idle_skipped << "\n"
+            << "frames:       " << stats.frames << "\n"
+            << "seconds:      " << stats.seconds << "\n"
+            << "instrs/sec:   " << stats.InstructionsPerSec() << "\n"
+            << "frames/sec:   " << stats.FramesPerSec() << "\n";
+
+  return EXIT_SUCCESS;
+}
+
+// Static recompiler: writes C++ for one ROM; built into the emulator, it is
+// picked up by `--headless --core aot` for that ROM
+int RunRecompile(int argc, char** argv) {
   if (argc != 4) {
-    std::cerr << "Usage: " << argv[0] << " <Scale> <Delay> <ROM> \n";
+    std::cerr << "Usage: " << argv[0] << " --recompile <ROM> <Out.cpp> \n";
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out(argv[3]);
+
+  if (!out.is_open() || !RecompileRom(argv[2], out)) {
+    std::cerr << "Cannot recompile " << argv[2] << " into " << argv[3] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Replays an input log headlessly as fast as the host allows; the printed
+// state matches the recorded session at its last frame
+int RunReplay(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " --replay <Log> <ROM> \n";
+    return EXIT_FAILURE;
+  }
+
+  InputReplay replay;
+
+  if (!replay.Open(argv[2])) {
+    std::cerr << "Cannot read input log: " << argv[2] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Chip8 chip8_obj;
+
+  if (!chip8_obj.LoadRom(argv[3])) {
+    std::cerr << "Cannot load ROM (missing or over " << MAX_ROM_SIZE
+              << " bytes): " << argv[3] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  chip8_obj.Seed(replay.Seed());
+
+  // Audio rendered too (and discarded) -> the tone count is reproducible
+  NullAudioSink audio;
+  AudioSynth synth(audio);
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (replay.Next(chip8_obj.keypad8_16)) {
+    StepFrameWithAudio(chip8_obj, replay.InstructionsPerFrame(), synth);
+  }
+
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "frames:       " << replay.Frames() << "\n"
+            << "seconds:      " << seconds.count() << "\n"
+            << "pc:           " << chip8_obj.pc16 << "\n"
+            << "memory hash:  "
+            << HashRom(chip8_obj.memory8_4kb, sizeof(chip8_obj.memory8_4kb))
+            << "\n"
+            << "video hash:   "
+            << HashRom(reinterpret_cast<uint8_t const*>(chip8_obj.video64_32),
+                       sizeof(chip8_obj.video64_32))
+            << "\n"
+            << "tone samples: " << audio.ToneSamples() << "\n"
+            << "idle skipped: " << chip8_obj.idle_skipped << "\n";
+
+#if CHIP8_STATS
+  chip8_obj.FlushStats();
+  DumpStats(chip8_obj.stats, std::cout);
+#endif
+
+  return EXIT_SUCCESS;
+}
+
+// Replays an input log on the table core under GuestProfiler -> folded
+// stacks for flame graphs and a per-byte memory heatmap
+int RunProfile(int argc, char** argv) {
+  if (argc != 7) {
+    std::cerr << "Usage: " << argv[0]
+              << " --profile <Period> <Log> <ROM> <Stacks.folded> "
+                 "<Heatmap.csv> \n";
+    return EXIT_FAILURE;
+  }
+
+  unsigned int period = std::stoul(argv[2]);  // 0 = default
+  InputReplay replay;
+
+  if (!replay.Open(argv[3])) {
+    std::cerr << "Cannot read input log: " << argv[3] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Chip8 chip8_obj;
+
+  if (!chip8_obj.LoadRom(argv[4])) {
+    std::cerr << "Cannot load ROM (missing or over " << MAX_ROM_SIZE
+              << " bytes): " << argv[4] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  chip8_obj.Seed(replay.Seed());
+
+  GuestProfiler profiler(chip8_obj, period ? period : PROFILE_DEFAULT_PERIOD);
+
+  while (replay.Next(chip8_obj.keypad8_16)) {
+    profiler.StepFrame(replay.InstructionsPerFrame());
+  }
+
+  std::ofstream stacks(argv[5]);
+  std::ofstream heatmap(argv[6]);
+
+  if (!stacks.is_open() || !heatmap.is_open()) {
+    std::cerr << "Cannot write " << argv[5] << " / " << argv[6] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  profiler.WriteFoldedStacks(stacks);
+  profiler.WriteHeatmap(heatmap);
+
+  std::cout << "frames:       " << replay.Frames() << "\n"
+            << "instructions: " << profiler.Instructions() << "\n"
+            << "samples:      " << profiler.Samples() << "\n";
+
+  return EXIT_SUCCESS;
+}
+
+// Micro, dispatch and whole-ROM benchmarks on every core; JSON on stdout,
+// progress on stderr
+int RunBench(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " --bench <Instructions> [ROM...] \n";
+    return EXIT_FAILURE;
+  }
+
+  uint64_t instructions = std::stoull(argv[2]);  // per run, 0 = default
+  std::vector<char const*> roms(argv + 3, argv + argc);
+
+  if (!RunBenchmarks(instructions ? instructions : BENCH_DEFAULT_INSTRUCTIONS,
+                     roms, std::cout)) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// PGO training run (`make pgo`): scripted input, throughput on stdout
+int RunTrain(int argc, char** argv) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0] << " --train <Frames> <ROM> [ROM...] \n";
+    return EXIT_FAILURE;
+  }
+
+  uint64_t frames = std::stoull(argv[2]);  // 0 = default
+  std::vector<char const*> roms(argv + 3, argv + argc);
+
+  if (!RunTraining(frames ? frames : TRAIN_DEFAULT_FRAMES, roms, std::cout)) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Lockstep batch: <Lanes> copies of one ROM, own seeds and key presses,
+// stepped together by BatchCore; throughput and lockstep share on stdout
+int RunBatch(int argc, char** argv) {
+  if (argc != 6) {
+    std::cerr << "Usage: " << argv[0]
+              << " --batch <Lanes> <Frames> <IPF> <ROM> \n";
+    return EXIT_FAILURE;
+  }
+
+  unsigned int lanes = std::stoul(argv[2]);
+  unsigned int frames = std::stoul(argv[3]);
+  unsigned int instructions_per_frame = std::stoul(argv[4]);
+
+  if (lanes == 0 || instructions_per_frame == UNCAPPED) {
+    std::cerr << "Batch mode needs <Lanes> > 0 and <IPF> > 0\n";
+    return EXIT_FAILURE;
+  }
+
+  Chip8 prototype;
+
+  if (!prototype.LoadRom(argv[5])) {
+    std::cerr << "Cannot load ROM (missing or over " << MAX_ROM_SIZE
+              << " bytes): " << argv[5] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  BatchCore batch(prototype, lanes);
+
+  for (unsigned int lane = 0; lane < lanes; ++lane) {
+    batch.Seed(lane, lane + 1);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    // Lane l taps key (frame / 16 + l) % 16 for 4 of every 16 frames,
+    // offset by l -> lanes drift apart like independent players
+    for (unsigned int lane = 0; lane < lanes; ++lane) {
+      uint8_t keys[16]{};
+
+      if ((frame + lane) % 16 < 4) {
+        keys[(frame / 16 + lane) % 16] = 1;
+      }
+
+      batch.SetKeys(lane, keys);
+    }
+
+    batch.StepFrame(instructions_per_frame);
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  BatchStats const& stats = batch.Stats();
+  uint64_t instructions = stats.lockstep + stats.scalar;
+
+  std::cout << "lanes:          " << lanes << "\n"
+            << "avx2:           " << (batch.Vectorized() ? "yes" : "no")
+            << "\n"
+            << "instructions:   " << instructions << "\n"
+            << "seconds:        " << seconds << "\n"
+            << "instrs/sec:     " << (seconds > 0 ? instructions / seconds : 0)
+            << "\n"
+            << "lockstep share: " << stats.LockstepShare() << "\n";
+
+  return EXIT_SUCCESS;
+}
+
+// SUPER-CHIP / XO-CHIP window: 128x64 display (lo-res ROMs drawn 2x2),
+// paced at 60 Hz. No rewind, recording or uncapped mode here
+template <typename Machine>
+int RunExtended(int argc, char** argv) {
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0] << " " << argv[1]
+              << " <Scale> <IPF> <ROM> \n";
+    return EXIT_FAILURE;
+  }
+
+  int video_scale = std::stoi(argv[2]);  // per lo-res pixel, like <Scale>
+  unsigned int instructions_per_frame = std::stoul(argv[3]);  // 0 = default
+  char const* rom_file_name = argv[4];
+
+  if (instructions_per_frame == 0) {
+    instructions_per_frame = DEFAULT_INSTRUCTIONS_PER_FRAME;
+  }
+
+  Machine machine;
+
+  if (!machine.LoadRom(rom_file_name)) {
+    std::cerr << "Cannot load ROM (missing or over " << Machine::MAX_ROM_SIZE
+              << " bytes): " << rom_file_name << "\n";
+    return EXIT_FAILURE;
+  }
+
+  Platform platform_obj("CHIP-8 INTERPRETER", VIDEO_WIDTH * video_scale,
+                        VIDEO_HEIGHT * video_scale, HIRES_WIDTH,
+                        HIRES_HEIGHT);
+  FramePacer pacer(std::chrono::nanoseconds(1000000000 / TIMER_HZ));
+
+  // After platform_obj -> the device closes before SDL_Quit
+  SdlAudioSink sdl_audio;
+  NullAudioSink no_audio;
+  AudioSynth synth(sdl_audio.IsOpen() ? static_cast<AudioSink&>(sdl_audio)
+                                      : no_audio);
+
+  while (!platform_obj.ProcessInput(machine.keypad8_16)) {
+    if (Machine::XO_CHIP) {
+      synth.SetPattern(machine.pattern8_16, machine.pitch8);  // F002/Fx3A
+    }
+
+    StepFrameWithAudio(machine, instructions_per_frame, synth);
+
+    platform_obj.Update(machine.Video(), HIRES_ROW_WORDS,
+                        sizeof(machine.video) / sizeof(machine.video[0]),
+                        machine.dirty_rows64);
+    machine.dirty_rows64 = 0;
+    pacer.Wait();
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string(argv[1]) == "--headless") {
+    return RunHeadless(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--recompile") {
+    return RunRecompile(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--replay") {
+    return RunReplay(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--profile") {
+    return RunProfile(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--bench") {
+    return RunBench(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--train") {
+    return RunTrain(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--batch") {
+    return RunBatch(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--schip") {
+    return RunExtended<SuperChip8>(argc, argv);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--xochip") {
+    return RunExtended<XoChip8>(argc, argv);
+  }
+
+  // <IPF> = instructions per 60 Hz frame (10 -> 600 instructions/sec),
+  // 0 = uncapped CPU with the timers still at 60 Hz
+  bool record = argc == 6 && std::string(argv[4]) == "--record";
+
+  if (argc != 4 && !record) {
+    std::cerr << "Usage: " << argv[0]
+              << " <Scale> <IPF> <ROM> [--record <Log>] \n"
+              << "       " << argv[0]
+              << " --headless [--core table|predecoded|jit|aot] <Threads> "
+                 "<Frames> <IPF> <Copies> <ROM> [ROM...] \n"
+              << "       " << argv[0] << " --recompile <ROM> <Out.cpp> \n"
+              << "       " << argv[0] << " --replay <Log> <ROM> \n"
+              << "       " << argv[0]
+              << " --profile <Period> <Log> <ROM> <Stacks.folded> "
+                 "<Heatmap.csv> \n"
+              << "       " << argv[0] << " --bench <Instructions> [ROM...] \n"
+              << "       " << argv[0] << " --train <Frames> <ROM> [ROM...] \n"
+              << "       " << argv[0]
+              << " --batch <Lanes> <Frames> <IPF> <ROM> \n"
+              << "       " << argv[0] << " --schip <Scale> <IPF> <ROM> \n"
+              << "       " << argv[0] << " --xochip <Scale> <IPF> <ROM> \n";
     std::exit(EXIT_FAILURE);
   }
 
   int video_scale = std::stoi(argv[1]);
-  int cycle_delay = std::stoi(argv[2]);
+  unsigned int instructions_per_frame = std::stoul(argv[2]);
   char const* rom_file_name = argv[3];
 
   Platform platform_obj("CHIP-8 INTERPRETER", VIDEO_WIDTH * video_scale,
@@ -20,31 +574,133 @@ int main(int argc, char** argv) {
 
   Chip8 chip8_obj;
 
-  chip8_obj.LoadRom(rom_file_name);
+  if (!chip8_obj.LoadRom(rom_file_name)) {
+    std::cerr << "Cannot load ROM (missing or over " << MAX_ROM_SIZE
+              << " bytes): " << rom_file_name << "\n";
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Recording: fixed seed + per-frame keypad -> `--replay` reproduces the run
+  InputRecorder recorder;
+
+  if (record) {
+    if (instructions_per_frame == UNCAPPED) {
+      std::cerr << "Recording needs <IPF> > 0\n";
+      std::exit(EXIT_FAILURE);
+    }
+
+    uint64_t seed = std::chrono::system_clock::now().time_since_epoch().count();
+    chip8_obj.Seed(seed);
+
+    if (!recorder.Open(argv[5], seed, instructions_per_frame)) {
+      std::cerr << "Cannot write input log: " << argv[5] << "\n";
+      std::exit(EXIT_FAILURE);
+    }
+  }
 
   //std::cout << "ROM LOADED" << std::endl;
 
-  int video_pitch = sizeof(chip8_obj.video32_64_32[0]) * VIDEO_WIDTH;
+  Scheduler scheduler(chip8_obj, instructions_per_frame);
+  FramePacer pacer(std::chrono::nanoseconds(1000000000 / TIMER_HZ));
+
+  // After platform_obj -> the device closes before SDL_Quit
+  SdlAudioSink sdl_audio;
+  NullAudioSink no_audio;
+  AudioSynth synth(sdl_audio.IsOpen() ? static_cast<AudioSink&>(sdl_audio)
+                                      : no_audio);
+
+  if (!sdl_audio.IsOpen()) {
+    std::cerr << "No audio device -> running silent\n";
+  }
+
+  scheduler.SetAudio(&synth);
 
-  auto last_cycle_time = std::chrono::high_resolution_clock::now();
+  // The core runs on its own thread; this one waits for input or a frame and
+  // presents the newest one -> a slow upload/present never stalls emulation
+  HostInput input;
+  TripleBuffer frames;
+
+  std::thread emulation(Emulate, std::ref(chip8_obj), std::ref(scheduler),
+                        std::ref(recorder), std::ref(input), std::ref(frames),
+                        std::ref(pacer), std::ref(synth),
+                        std::ref(platform_obj));
+
+  uint8_t keys[sizeof(chip8_obj.keypad8_16)]{};
+  uint64_t shown[VIDEO_HEIGHT]{};  // rows on screen
   bool quit = false;
 
   while (!quit) {
-    quit = platform_obj.ProcessInput(chip8_obj.keypad8_16);
+    quit = platform_obj.ProcessInput(keys);
+
+    input.StoreKeys(keys);
+    input.rewinding.store(platform_obj.Rewinding(),
+                          std::memory_order_relaxed);
 
-    auto current_time = std::chrono::high_resolution_clock::now();
-    float dt = std::chrono::duration<float, std::chrono::milliseconds::period>(
-                   current_time - last_cycle_time)
-                   .count();
+    if (platform_obj.StatsRequested()) {
+      input.stats_requested.store(true);
+    }
+
+    // Frames skipped in between don't matter: dirty = rows that differ
+    VideoFrame const* frame = frames.Acquire();
+    uint32_t dirty_rows = 0;
 
-    if (dt > cycle_delay) {
-      last_cycle_time = current_time;
+    if (frame != nullptr) {
+      for (unsigned int y = 0; y < VIDEO_HEIGHT; ++y) {
+        dirty_rows |= uint32_t{frame->rows[y] != shown[y]} << y;
+        shown[y] = frame->rows[y];
+      }
+    }
 
-      chip8_obj.Cycle();
+    platform_obj.Update(shown, dirty_rows);  // also redraws after expose
 
-      platform_obj.Update(chip8_obj.video32_64_32, video_pitch);
+    // Nothing new -> block (no polling) until a key, expose or frame; the
+    // handoff latency is then publish -> this wake-up -> Acquire()
+    if (frame == nullptr) {
+      platform_obj.WaitForEvent(RENDER_WAIT_TIMEOUT_MS);
     }
   }
 
+  input.Quit();
+  emulation.join();
+
+  if (recorder.IsOpen() && !recorder.Close()) {
+    std::cerr << "Input log incomplete: " << argv[5] << "\n";
+  }
+
+  if (!scheduler.Uncapped()) {
+    PacerStats const& stats = pacer.Stats();
+
+    std::cout << "frames: " << stats.frames
+              << " | overruns: " << stats.overruns
+              << " | mean jitter: " << stats.MeanJitterUs() << " us"
+              << " | max jitter: " << stats.max_jitter_ns / 1000.0 << " us\n";
+  }
+
+  // Dropped: frames owed after a host stall past MAX_CATCH_UP_FRAMES
+  std::cout << "emulated: " << scheduler.Frames() << " frames"
+            << " | instructions: " << scheduler.Instructions()
+            << " | dropped: " << scheduler.DroppedFrames() << " frames\n";
+
+  HandoffStats const& handoff = frames.Stats();
+
+  std::cout << "presented: " << handoff.frames
+            << " | skipped: " << handoff.dropped
+            << " | mean handoff: " << handoff.MeanLatencyUs() << " us"
+            << " | max handoff: " << handoff.max_latency_ns / 1000.0
+            << " us\n"
+            << "idle skipped: " << chip8_obj.idle_skipped << " instructions\n";
+
+  if (sdl_audio.IsOpen()) {
+    std::cout << "audio latency: mean " << sdl_audio.LatencyMs() << " ms"
+              << " | max " << sdl_audio.MaxLatencyMs() << " ms"
+              << " | underruns: " << sdl_audio.Underruns()
+              << " | dropped: " << sdl_audio.Dropped() << " samples\n";
+  }
+
+#if CHIP8_STATS
+  chip8_obj.FlushStats();
+  DumpStats(chip8_obj.stats, std::cout);
+#endif
+
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,79 @@
+#include "pacer.h"
+
+#include <thread>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <time.h>
+#endif
+
+// Wake this long before the deadline and spin the remainder. Windows sleeps
+// in scheduler ticks (~1 ms at best), Linux timers are far finer.
+#if defined(_WIN32)
+const std::chrono::microseconds PACER_SPIN_MARGIN(2000);
+#else
+const std::chrono::microseconds PACER_SPIN_MARGIN(100);
+#endif
+
+double PacerStats::MeanJitterUs() const {
+  uint64_t on_time = frames - overruns;
+  return on_time > 0 ? total_jitter_ns / 1000.0 / on_time : 0.0;
+}
+
+FramePacer::FramePacer(std::chrono::nanoseconds period) : period(period) {
+  Reset();
+}
+
+void FramePacer::Reset() {
+  deadline = std::chrono::steady_clock::now() + period;
+}
+
+void FramePacer::Wait() {
+  ++stats.frames;
+
+  auto now = std::chrono::steady_clock::now();
+
+  if (now >= deadline) {
+    // Frame work took longer than a period -> resync instead of bursting
+    ++stats.overruns;
+    deadline = now + period;
+    return;
+  }
+
+  SleepUntil(deadline - PACER_SPIN_MARGIN);
+
+  // Spin the last stretch, sleeping can't hit the deadline exactly
+  while ((now = std::chrono::steady_clock::now()) < deadline) {
+  }
+
+  int64_t jitter_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline)
+          .count();
+
+  stats.total_jitter_ns += jitter_ns;
+
+  if (jitter_ns > stats.max_jitter_ns) {
+    stats.max_jitter_ns = jitter_ns;
+  }
+
+  // Next deadline from the previous one, not from `now` -> no drift
+  deadline += period;
+}
+
+void FramePacer::SleepUntil(std::chrono::steady_clock::time_point wake) {
+#if defined(__linux__)
+  // steady_clock is CLOCK_MONOTONIC on Linux -> absolute, EINTR-safe sleep
+  auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      wake.time_since_epoch());
+
+  timespec ts;
+  ts.tv_sec = since_epoch.count() / 1000000000;
+  ts.tv_nsec = since_epoch.count() % 1000000000;
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+#else
+  std::this_thread::sleep_until(wake);
+#endif
+}
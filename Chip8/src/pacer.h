@@ -0,0 +1,39 @@
+#ifndef CHIP8_PACER_H
+
+#define CHIP8_PACER_H
+
+#include <chrono>
+#include <cstdint>
+
+struct PacerStats {
+  uint64_t frames{};         // Wait() calls
+  uint64_t overruns{};       // frames that missed their deadline
+  int64_t total_jitter_ns{};  // sum of |wake - deadline| for on-time frames
+  int64_t max_jitter_ns{};
+
+  double MeanJitterUs() const;
+};
+
+// Sleeps the host thread until the next frame deadline instead of polling.
+// Deadlines are absolute (previous + period) so sleep error never accumulates
+// into drift; the thread sleeps until shortly before the deadline and spins
+// the rest, which keeps wake-up jitter in the microseconds.
+class FramePacer {
+ public:
+  explicit FramePacer(std::chrono::nanoseconds period);
+
+  void Wait();  // block until the next deadline, then schedule the one after
+  void Reset();  // restart deadlines from now (e.g. after a pause)
+
+  PacerStats const& Stats() const { return stats; }
+
+ private:
+  void SleepUntil(std::chrono::steady_clock::time_point deadline);
+
+  std::chrono::nanoseconds period;
+  std::chrono::steady_clock::time_point deadline;
+
+  PacerStats stats;
+};
+
+#endif  // CHIP8_PACER_H
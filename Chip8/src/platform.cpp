@@ -3,7 +3,10 @@
 #include <SDL.h>
 
 Platform::Platform(char const* title, int windowWidth, int windowHeight,
-                   int textureWidth, int textureHeight) {
+                   int textureWidth, int textureHeight)
+    : texture_width(textureWidth),
+      texture_height(textureHeight),
+      pixels(textureWidth * textureHeight) {
   SDL_Init(SDL_INIT_VIDEO);
 
   window = SDL_CreateWindow(title, 0, 0, windowWidth, windowHeight,
@@ -14,6 +17,8 @@ Platform::Platform(char const* title, int windowWidth, int windowHeight,
   texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
                               SDL_TEXTUREACCESS_STREAMING, textureWidth,
                               textureHeight);
+
+  wake_event = SDL_RegisterEvents(1);
 }
 
 Platform::~Platform() {
@@ -24,12 +29,85 @@ Platform::~Platform() {
   SDL_Quit();
 }
 
-void Platform::Update(void const* buffer, int pitch) {
-  SDL_UpdateTexture(texture, nullptr, buffer, pitch);
+// Off, plane 1, plane 2, both (RGBA8888)
+static uint32_t const PLANE_PALETTE[4] = {0x00000000u, 0xFFFFFFFFu,
+                                          0xAAAAAAFFu, 0x555555FFu};
+
+void Platform::Update(uint64_t const* rows, uint32_t dirty_rows) {
+  Update(rows, 1, 1, dirty_rows);
+}
+
+void Platform::Update(uint64_t const* rows, unsigned int words_per_row,
+                      unsigned int planes, uint64_t dirty_rows) {
+  if (dirty_rows == 0 && !exposed) {
+    return;  // nothing new on screen -> no upload, no present
+  }
+
+  // Upload one band: first to last changed row (all of them after expose)
+  int first = 0;
+  int last = texture_height - 1;
+
+  if (!exposed) {
+    while (!(dirty_rows & (uint64_t{1} << first))) {
+      ++first;
+    }
+
+    while (!(dirty_rows & (uint64_t{1} << last))) {
+      --last;
+    }
+  }
+
+  std::size_t plane_words = std::size_t{words_per_row} * texture_height;
+
+  // Expand each pixel's plane bits to a whole RGBA pixel
+  for (int y = first; y <= last; ++y) {
+    uint32_t* line = &pixels[y * texture_width];
+    uint64_t const* row = &rows[y * words_per_row];
+
+    for (int x = 0; x < texture_width; ++x) {
+      unsigned int color = 0;
+
+      for (unsigned int plane = 0; plane < planes; ++plane) {
+        uint64_t word = row[plane * plane_words + x / 64];
+        color |= ((word >> (63 - x % 64)) & 1u) << plane;
+      }
+
+      line[x] = PLANE_PALETTE[color];
+    }
+  }
+
+  int pitch = texture_width * sizeof(pixels[0]);
+  SDL_Rect band{0, first, texture_width, last - first + 1};
+
+  SDL_UpdateTexture(texture, &band, &pixels[first * texture_width], pitch);
 
   SDL_RenderClear(renderer);
   SDL_RenderCopy(renderer, texture, nullptr, nullptr);
   SDL_RenderPresent(renderer);
+
+  exposed = false;
+}
+
+bool Platform::StatsRequested() {
+  bool requested = stats_requested;
+  stats_requested = false;
+
+  return requested;
+}
+
+void Platform::WaitForEvent(int timeout_ms) {
+  SDL_WaitEventTimeout(nullptr, timeout_ms);
+}
+
+void Platform::Wake() {
+  if (wake_event == static_cast<uint32_t>(-1) ||
+      wake_pending.exchange(true, std::memory_order_acq_rel)) {
+    return;  // no event type, or one already on its way
+  }
+
+  SDL_Event event{};
+  event.type = wake_event;
+  SDL_PushEvent(&event);
 }
 
 bool Platform::ProcessInput(uint8_t* keys) {
@@ -38,17 +116,39 @@ bool Platform::ProcessInput(uint8_t* keys) {
   SDL_Event event;
 
   while (SDL_PollEvent(&event)) {
+    if (event.type == wake_event) {
+      // Cleared before the caller looks for a frame -> a frame published
+      // after this pushes a new wake
+      wake_pending.store(false, std::memory_order_release);
+      continue;
+    }
+
     switch (event.type) {
       case SDL_QUIT: {
         quit = true;
       } break;
 
+      case SDL_WINDOWEVENT: {
+        // Window contents were lost -> next Update() redraws everything
+        if (event.window.event == SDL_WINDOWEVENT_EXPOSED) {
+          exposed = true;
+        }
+      } break;
+
       case SDL_KEYDOWN: {
         switch (event.key.keysym.sym) {
           case SDLK_ESCAPE: {
             quit = true;
           } break;
 
+          case SDLK_BACKSPACE: {
+            rewinding = true;
+          } break;
+
+          case SDLK_TAB: {
+            stats_requested = true;
+          } break;
+
           case SDLK_x: {
             keys[0] = 1;
           } break;
@@ -117,6 +217,10 @@ bool Platform::ProcessInput(uint8_t* keys) {
 
       case SDL_KEYUP: {
         switch (event.key.keysym.sym) {
+          case SDLK_BACKSPACE: {
+            rewinding = false;
+          } break;
+
           case SDLK_x: {
             keys[0] = 0;
           } break;
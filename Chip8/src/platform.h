@@ -2,7 +2,9 @@
 
 #define CHIP8_PLATFORM_H
 
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 struct SDL_Window;
 struct SDL_Renderer;
@@ -13,13 +15,42 @@ class Platform {
   Platform(char const* title, int windowWidth, int windowHeight,
            int textureWidth, int textureHeight);
   ~Platform();
-  void Update(void const* buffer, int pitch);
+  // `rows`: one word per row, MSB = leftmost. Uploads and presents only if
+  // some row changed (bit y of `dirty_rows`) or the window was exposed
+  void Update(uint64_t const* rows, uint32_t dirty_rows);
+
+  // Wider/taller/colour displays (SUPER-CHIP, XO-CHIP): `planes` bitplanes
+  // one after the other, each `words_per_row` words per row, MSB of a row's
+  // first word = leftmost. A pixel's plane bits pick its PLANE_PALETTE entry
+  void Update(uint64_t const* rows, unsigned int words_per_row,
+              unsigned int planes, uint64_t dirty_rows);
   bool ProcessInput(uint8_t* keys);
 
+  // Sleep until an event is queued (input, expose, Wake()) or `timeout_ms`
+  // passes; the event is left for ProcessInput(). Window thread only
+  void WaitForEvent(int timeout_ms);
+
+  // Any thread (SDL_PushEvent is thread-safe): wake WaitForEvent(). Wakes
+  // not yet seen by ProcessInput() are folded into one event
+  void Wake();
+
+  bool Rewinding() const { return rewinding; }  // Backspace held
+  bool StatsRequested();  // Tab pressed since the last call
+
  private:
   SDL_Window* window{};
   SDL_Renderer* renderer{};
   SDL_Texture* texture{};
+
+  int texture_width{};
+  int texture_height{};
+  std::vector<uint32_t> pixels;  // RGBA, only filled when presenting
+  bool exposed{true};            // texture never uploaded / window damaged
+  bool rewinding{};
+  bool stats_requested{};
+
+  uint32_t wake_event{};  // SDL_RegisterEvents() type, (uint32_t)-1: none
+  std::atomic<bool> wake_pending{};
 };
 
 #endif  // CHIP8_PLATFORM_H
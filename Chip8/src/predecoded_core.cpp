@@ -0,0 +1,473 @@
+#include "predecoded_core.h"
+
+#include <cstring>
+
+// Computed goto is a GCC/Clang extension; MSVC gets the switch loop
+#if defined(__GNUC__)
+#define PREDECODED_COMPUTED_GOTO 1
+#else
+#define PREDECODED_COMPUTED_GOTO 0
+#endif
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8::memory8_4kb);
+
+PredecodedCore::PredecodedCore(Chip8& chip8) : chip8(chip8) { Invalidate(); }
+
+void PredecodedCore::Invalidate() {
+  for (Decoded& entry : code) {
+    entry.handler = DECODE;
+  }
+}
+
+void PredecodedCore::InvalidateRange(uint16_t address, unsigned int length) {
+  // The record at `a` covers bytes a and a + 1 -> also drop the one before.
+  // Stores wrap at 4 KB, so the range does too
+  for (unsigned int n = 0; n <= length; ++n) {
+    code[(address - 1u + n) & ADDRESS_MASK].handler = DECODE;
+  }
+}
+
+PredecodedCore::Decoded PredecodedCore::Decode(uint16_t opcode) {
+  Decoded entry;
+
+  entry.x = (opcode & 0x0F00u) >> 8u;
+  entry.y = (opcode & 0x00F0u) >> 4u;
+  entry.nn = opcode & 0x00FFu;
+  entry.nnn = opcode & 0x0FFFu;
+  entry.opcode = opcode;
+  entry.handler = NOP;  // anything the tables map to Op_NULL
+
+  // Mirrors Chip8's table/table0/table8/tableE/tableF lookups exactly
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x0:
+      if ((opcode & 0x000Fu) == 0x0) entry.handler = CLS;
+      if ((opcode & 0x000Fu) == 0xE) entry.handler = RET;
+      break;
+
+    case 0x1: entry.handler = JP; break;
+    case 0x2: entry.handler = CALL; break;
+    case 0x3: entry.handler = SE_VX_NN; break;
+    case 0x4: entry.handler = SNE_VX_NN; break;
+    case 0x5: entry.handler = SE_VX_VY; break;
+    case 0x6: entry.handler = LD_VX_NN; break;
+    case 0x7: entry.handler = ADD_VX_NN; break;
+
+    case 0x8:
+      switch (opcode & 0x000Fu) {
+        case 0x0: entry.handler = LD_VX_VY; break;
+        case 0x1: entry.handler = OR_VX_VY; break;
+        case 0x2: entry.handler = AND_VX_VY; break;
+        case 0x3: entry.handler = XOR_VX_VY; break;
+        case 0x4: entry.handler = ADD_VX_VY; break;
+        case 0x5: entry.handler = SUB_VX_VY; break;
+        case 0x6: entry.handler = SHR_VX; break;
+        case 0x7: entry.handler = SUBN_VX_VY; break;
+        case 0xE: entry.handler = SHL_VX; break;
+      }
+      break;
+
+    case 0x9: entry.handler = SNE_VX_VY; break;
+    case 0xA: entry.handler = LD_I; break;
+    case 0xB: entry.handler = JP_V0; break;
+    case 0xC: entry.handler = RND; break;
+    case 0xD: entry.handler = DRW; break;
+
+    case 0xE:
+      if ((opcode & 0x000Fu) == 0x1) entry.handler = SKNP;
+      if ((opcode & 0x000Fu) == 0xE) entry.handler = SKP;
+      break;
+
+    case 0xF:
+      switch (opcode & 0x00FFu) {
+        case 0x07: entry.handler = LD_VX_DT; break;
+        case 0x0A: entry.handler = LD_VX_K; break;
+        case 0x15: entry.handler = LD_DT_VX; break;
+        case 0x18: entry.handler = LD_ST_VX; break;
+        case 0x1E: entry.handler = ADD_I_VX; break;
+        case 0x29: entry.handler = LD_F_VX; break;
+        case 0x33: entry.handler = LD_B_VX; break;
+        case 0x55: entry.handler = LD_MEM_VX; break;
+        case 0x65: entry.handler = LD_VX_MEM; break;
+      }
+      break;
+  }
+
+  return entry;
+}
+
+void PredecodedCore::SlowCycle(uint16_t& pc, uint16_t& I) {
+  // PC at the last byte or beyond -> Chip8 wraps the fetch at 4 KB
+  chip8.pc16 = pc;
+  chip8.index16 = I;
+  chip8.Cycle();
+
+  uint16_t opcode = chip8.opcode16;
+
+  if ((opcode & 0xF0FFu) == 0xF033u || (opcode & 0xF0FFu) == 0xF055u) {
+    InvalidateRange(I, ((opcode & 0x0F00u) >> 8u) + 3u);
+  }
+
+  pc = chip8.pc16;
+  I = chip8.index16;
+}
+
+unsigned int PredecodedCore::StepFrame(unsigned int instructions) {
+  unsigned int ran = Run(instructions);
+  chip8.TickTimers();
+  return ran;
+}
+
+unsigned int PredecodedCore::Run(unsigned int instructions) {
+  if (instructions == 0 || chip8.Halted()) {
+    return 0;
+  }
+
+  unsigned int ran = 0;
+
+  // One switch per call -> the loop below is compiled once per profile
+  WithQuirks(chip8.Quirks(), [this, instructions, &ran](auto policy) {
+    ran = RunWith<decltype(policy)>(instructions);
+  });
+
+  return ran;
+}
+
+template <typename Policy>
+unsigned int PredecodedCore::RunWith(unsigned int instructions) {
+  Chip8& c = chip8;
+  uint8_t* const V = c.registers8_16;
+  uint8_t* const memory = c.memory8_4kb;
+
+  // Hot state lives in locals; written back before delegating and at the end
+  uint16_t pc = c.pc16;
+  uint16_t I = c.index16;
+  unsigned int remaining = instructions;
+  unsigned int halted_with = 0;  // `remaining` when Fx0A halted -> not run
+  Decoded* e = nullptr;
+
+#if PREDECODED_COMPUTED_GOTO
+  // Same order as the Handler enum
+  static void* const labels[HANDLER_COUNT] = {
+      &&op_DECODE,    &&op_NOP,        &&op_CLS,        &&op_RET,
+      &&op_JP,        &&op_CALL,       &&op_SE_VX_NN,   &&op_SNE_VX_NN,
+      &&op_SE_VX_VY,  &&op_LD_VX_NN,   &&op_ADD_VX_NN,  &&op_LD_VX_VY,
+      &&op_OR_VX_VY,  &&op_AND_VX_VY,  &&op_XOR_VX_VY,  &&op_ADD_VX_VY,
+      &&op_SUB_VX_VY, &&op_SHR_VX,     &&op_SUBN_VX_VY, &&op_SHL_VX,
+      &&op_SNE_VX_VY, &&op_LD_I,       &&op_JP_V0,      &&op_RND,
+      &&op_DRW,       &&op_SKP,        &&op_SKNP,       &&op_LD_VX_DT,
+      &&op_LD_VX_K,   &&op_LD_DT_VX,   &&op_LD_ST_VX,   &&op_ADD_I_VX,
+      &&op_LD_F_VX,   &&op_LD_B_VX,    &&op_LD_MEM_VX,  &&op_LD_VX_MEM};
+
+// Each handler ends in its own copy of fetch + indirect jump
+#define HANDLER(name) op_##name:
+#define REDISPATCH() goto* labels[e->handler]
+#define NEXT()                                  \
+  do {                                          \
+    if (remaining == 0) goto done;              \
+    --remaining;                                \
+    if (pc >= MEMORY_SIZE - 1) goto slow_path;  \
+    e = &code[pc];                              \
+    pc += 2;                                    \
+    goto* labels[e->handler];                   \
+  } while (0)
+
+  NEXT();
+#else
+#define HANDLER(name) case name:
+#define REDISPATCH() goto redispatch
+#define NEXT() continue
+
+  for (;;) {
+    if (remaining == 0) goto done;
+    --remaining;
+
+    if (pc >= MEMORY_SIZE - 1) {
+      SlowCycle(pc, I);
+      e = nullptr;
+
+      if (c.key_wait8 != 0) {
+        halted_with = remaining;  // Fx0A fetched across the 4 KB wrap
+        remaining = 0;
+      }
+
+      continue;
+    }
+
+    e = &code[pc];
+    pc += 2;
+
+  redispatch:
+    switch (e->handler) {
+#endif
+
+  HANDLER(DECODE) {
+    unsigned int at = static_cast<unsigned int>(e - code);
+    *e = Decode((memory[at] << 8u) | memory[at + 1]);
+    REDISPATCH();
+  }
+
+  HANDLER(NOP) { NEXT(); }
+
+  HANDLER(CLS) {
+    c.Op_00E0();
+    NEXT();
+  }
+
+  HANDLER(RET) {
+    --c.sp8;
+    pc = c.stack16_16[c.sp8 & STACK_MASK];
+    NEXT();
+  }
+
+  HANDLER(JP) {
+    uint16_t from = pc - 2;
+    pc = e->nnn;
+
+    // Short backward jump -> skip whole passes of an idle loop, as
+    // Chip8::SkipIdle does
+    if (c.skip_idle && pc <= from &&
+        from - pc < static_cast<int>(IDLE_LOOP_SPAN)) {
+      unsigned int length = c.IdleLoopLength(pc, e->opcode);
+
+      if (length != 0) {
+        unsigned int skipped = remaining / length * length;
+        remaining -= skipped;
+        c.idle_skipped += skipped;
+      }
+    }
+
+    NEXT();
+  }
+
+  HANDLER(CALL) {
+    c.stack16_16[c.sp8 & STACK_MASK] = pc;
+    ++c.sp8;
+    pc = e->nnn;
+    NEXT();
+  }
+
+  HANDLER(SE_VX_NN) {
+    if (V[e->x] == e->nn) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(SNE_VX_NN) {
+    if (V[e->x] != e->nn) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(SE_VX_VY) {
+    if (V[e->x] == V[e->y]) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(LD_VX_NN) {
+    V[e->x] = e->nn;
+    NEXT();
+  }
+
+  HANDLER(ADD_VX_NN) {
+    V[e->x] += e->nn;
+    NEXT();
+  }
+
+  HANDLER(LD_VX_VY) {
+    V[e->x] = V[e->y];
+    NEXT();
+  }
+
+  HANDLER(OR_VX_VY) {
+    V[e->x] |= V[e->y];
+    if (Policy::LOGIC_RESETS_VF) V[0xF] = 0;
+    NEXT();
+  }
+
+  HANDLER(AND_VX_VY) {
+    V[e->x] &= V[e->y];
+    if (Policy::LOGIC_RESETS_VF) V[0xF] = 0;
+    NEXT();
+  }
+
+  HANDLER(XOR_VX_VY) {
+    V[e->x] ^= V[e->y];
+    if (Policy::LOGIC_RESETS_VF) V[0xF] = 0;
+    NEXT();
+  }
+
+  // Flag ops keep Chip8's store order so x == F behaves identically
+
+  HANDLER(ADD_VX_VY) {
+    uint16_t sum = V[e->x] + V[e->y];
+    V[0xF] = sum > 255u ? 1 : 0;
+    V[e->x] = sum & 0xFFu;
+    NEXT();
+  }
+
+  HANDLER(SUB_VX_VY) {
+    V[0xF] = SubtractFlag(V[e->x], V[e->y]);
+    V[e->x] -= V[e->y];
+    NEXT();
+  }
+
+  HANDLER(SHR_VX) {
+    uint8_t source = Policy::SHIFT_VY ? e->y : e->x;
+    V[0xF] = V[source] & 0x1u;
+    V[e->x] = V[source] >> 1u;
+    NEXT();
+  }
+
+  HANDLER(SUBN_VX_VY) {
+    V[0xF] = SubtractFlag(V[e->y], V[e->x]);
+    V[e->x] = V[e->y] - V[e->x];
+    NEXT();
+  }
+
+  HANDLER(SHL_VX) {
+    uint8_t source = Policy::SHIFT_VY ? e->y : e->x;
+    V[0xF] = (V[source] & 0x80u) >> 7u;
+    V[e->x] = V[source] << 1u;
+    NEXT();
+  }
+
+  HANDLER(SNE_VX_VY) {
+    if (V[e->x] != V[e->y]) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(LD_I) {
+    I = e->nnn;
+    NEXT();
+  }
+
+  HANDLER(JP_V0) {
+    pc = e->nnn + V[Policy::JUMP_VX ? e->x : 0];
+    NEXT();
+  }
+
+  HANDLER(RND) {
+    // Delegate -> same RNG stream as Chip8::Cycle()
+    c.opcode16 = e->opcode;
+    c.Op_Cxnn();
+    NEXT();
+  }
+
+  HANDLER(DRW) {
+    c.opcode16 = e->opcode;
+    c.index16 = I;
+    ((c).*(c.table[0xD]))();  // the profile's Op_Dxyn (clip or wrap)
+    NEXT();
+  }
+
+  HANDLER(SKP) {
+    if (c.keypad8_16[V[e->x] & KEY_MASK]) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(SKNP) {
+    if (!c.keypad8_16[V[e->x] & KEY_MASK]) pc += 2;
+    NEXT();
+  }
+
+  HANDLER(LD_VX_DT) {
+    V[e->x] = c.delay_timer8;
+    NEXT();
+  }
+
+  HANDLER(LD_VX_K) {
+    int key = FirstKeyDown(c.keypad8_16);
+
+    if (key >= 0) {
+      V[e->x] = static_cast<uint8_t>(key);
+    } else {
+      // No key -> halt on this instruction, nothing left to run in this call
+      pc -= 2;
+      c.key_wait8 = 1;
+      halted_with = remaining;
+      remaining = 0;
+    }
+
+    NEXT();
+  }
+
+  HANDLER(LD_DT_VX) {
+    c.delay_timer8 = V[e->x];
+    NEXT();
+  }
+
+  HANDLER(LD_ST_VX) {
+    c.sound_timer8 = V[e->x];
+    NEXT();
+  }
+
+  HANDLER(ADD_I_VX) {
+    I += V[e->x];
+    NEXT();
+  }
+
+  HANDLER(LD_F_VX) {
+    I = FONTSET_START_ADDRESS + (V[e->x] * 5);
+    NEXT();
+  }
+
+  HANDLER(LD_B_VX) {
+    uint8_t value = V[e->x];
+
+    memory[(I + 2) & ADDRESS_MASK] = value % 10;
+    memory[(I + 1) & ADDRESS_MASK] = (value / 10) % 10;
+    memory[I & ADDRESS_MASK] = (value / 100) % 10;
+
+    InvalidateRange(I, 3);  // may be storing into code
+    NEXT();
+  }
+
+  HANDLER(LD_MEM_VX) {
+    for (uint8_t i = 0; i <= e->x; ++i) {
+      memory[(I + i) & ADDRESS_MASK] = V[i];
+    }
+
+    InvalidateRange(I, e->x + 1u);
+    if (Policy::LOAD_STORE_INCREMENTS_I) I += e->x + 1u;
+    NEXT();
+  }
+
+  HANDLER(LD_VX_MEM) {
+    for (uint8_t i = 0; i <= e->x; ++i) {
+      V[i] = memory[(I + i) & ADDRESS_MASK];
+    }
+
+    if (Policy::LOAD_STORE_INCREMENTS_I) I += e->x + 1u;
+    NEXT();
+  }
+
+#if PREDECODED_COMPUTED_GOTO
+slow_path:
+  SlowCycle(pc, I);
+  e = nullptr;
+
+  if (c.key_wait8 != 0) {
+    halted_with = remaining;  // Fx0A fetched across the 4 KB wrap
+    remaining = 0;
+  }
+
+  NEXT();
+#else
+      default:
+        NEXT();
+    }
+  }
+#endif
+
+done:
+  c.pc16 = pc;
+  c.index16 = I;
+
+  if (e != nullptr) {
+    c.opcode16 = e->opcode;  // as if Cycle() had fetched it
+  }
+
+#undef HANDLER
+#undef REDISPATCH
+#undef NEXT
+
+  return instructions - halted_with;
+}
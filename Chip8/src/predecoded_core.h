@@ -0,0 +1,93 @@
+#ifndef CHIP8_PREDECODED_CORE_H
+
+#define CHIP8_PREDECODED_CORE_H
+
+#include <cstdint>
+
+#include "chip_8.h"
+
+// Alternative interpreter for a Chip8's state: every address is decoded once
+// into a compact {handler, operands} record and then run with threaded
+// (computed-goto) dispatch on GCC/Clang, or a single switch elsewhere. No
+// member-function-pointer calls and no re-extraction of x/y/nn per op.
+//
+// Records are decoded lazily and dropped again when Fx55/Fx33 store into
+// them. Anything else that writes `memory8_4kb` behind the core's back
+// (LoadRom, a restored snapshot...) must be followed by Invalidate().
+// Records don't depend on the quirk profile: each Run picks the handler
+// loop instantiated for chip8.Quirks().
+class PredecodedCore {
+ public:
+  explicit PredecodedCore(Chip8& chip8);
+
+  // Same effect as N Chip8::Cycle(); returns how many ran, as StepFrame()
+  unsigned int Run(unsigned int instructions);
+  unsigned int StepFrame(unsigned int instructions);  // Chip8::StepFrame()
+
+  void Invalidate();  // forget every decoded record
+  void InvalidateRange(uint16_t address, unsigned int length);  // bytes
+
+  // Handler ids, in the order of the dispatch tables in the .cpp
+  enum Handler : uint8_t {
+    DECODE,  // not decoded yet (or invalidated)
+    NOP,
+    CLS,
+    RET,
+    JP,
+    CALL,
+    SE_VX_NN,
+    SNE_VX_NN,
+    SE_VX_VY,
+    LD_VX_NN,
+    ADD_VX_NN,
+    LD_VX_VY,
+    OR_VX_VY,
+    AND_VX_VY,
+    XOR_VX_VY,
+    ADD_VX_VY,
+    SUB_VX_VY,
+    SHR_VX,
+    SUBN_VX_VY,
+    SHL_VX,
+    SNE_VX_VY,
+    LD_I,
+    JP_V0,
+    RND,
+    DRW,
+    SKP,
+    SKNP,
+    LD_VX_DT,
+    LD_VX_K,
+    LD_DT_VX,
+    LD_ST_VX,
+    ADD_I_VX,
+    LD_F_VX,
+    LD_B_VX,
+    LD_MEM_VX,
+    LD_VX_MEM,
+    HANDLER_COUNT
+  };
+
+  struct Decoded {
+    uint8_t handler;
+    uint8_t x;
+    uint8_t y;
+    uint8_t nn;  // low byte (n = nn & 0xF)
+    uint16_t nnn;
+    uint16_t opcode;  // raw opcode, for ops delegated to Chip8
+  };
+
+  static Decoded Decode(uint16_t opcode);  // same mapping as Chip8's tables
+
+ private:
+  template <typename Policy>
+  unsigned int RunWith(unsigned int instructions);  // Run for one profile
+
+  void SlowCycle(uint16_t& pc, uint16_t& I);  // table dispatch, PC >= 0xFFF
+
+  Chip8& chip8;
+
+  Decoded code[sizeof(Chip8::memory8_4kb)]{};  // one record per address
+};
+
+#endif  // CHIP8_PREDECODED_CORE_H
@@ -0,0 +1,151 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "disassembler.h"
+
+const unsigned int MEMORY_SIZE = sizeof(Chip8State::memory8_4kb);
+const unsigned int STACK_DEPTH = 16;
+const uint16_t UNKNOWN_ENTRY = 0xFFFF;  // frame whose 2nnn wasn't seen
+
+GuestProfiler::GuestProfiler(Chip8& chip8, unsigned int period)
+    : chip8(chip8),
+      period(std::max(period, 1u)),
+      until_sample(this->period),
+      image(std::begin(chip8.memory8_4kb), std::end(chip8.memory8_4kb)),
+      fetches(MEMORY_SIZE),
+      reads(MEMORY_SIZE),
+      writes(MEMORY_SIZE) {
+  SyncCalls();
+}
+
+void GuestProfiler::Cycle() {
+  uint16_t pc = chip8.pc16 % MEMORY_SIZE;
+  uint16_t opcode = (chip8.memory8_4kb[pc] << 8u) |
+                    chip8.memory8_4kb[(pc + 1) % MEMORY_SIZE];
+
+  // Sample the instruction about to run, under the calls that led to it
+  if (--until_sample == 0) {
+    std::vector<uint16_t> stack = calls;
+    stack.push_back(pc);
+    ++stacks[stack];
+    ++samples;
+    until_sample = period;
+  }
+
+  Account(pc, opcode);
+  chip8.Cycle();
+  SyncCalls();
+  ++instructions;
+}
+
+void GuestProfiler::StepFrame(unsigned int instructions) {
+  for (unsigned int i = 0; i < instructions && !chip8.Halted(); ++i) {
+    Cycle();
+  }
+
+  chip8.TickTimers();
+}
+
+void GuestProfiler::Account(uint16_t pc, uint16_t opcode) {
+  ++fetches[pc];
+  ++fetches[(pc + 1) % MEMORY_SIZE];
+
+  unsigned int x = (opcode & 0x0F00u) >> 8u;
+  unsigned int index = chip8.index16;
+
+  // Accesses past 0xFFF wrap to the start of memory, as in Chip8
+  auto Count = [&](std::vector<uint64_t>& heatmap, unsigned int count) {
+    for (unsigned int i = 0; i < count; ++i) {
+      ++heatmap[(index + i) & ADDRESS_MASK];
+    }
+  };
+
+  switch ((opcode & 0xF000u) >> 12u) {
+    case 0x2:
+      if (calls.size() < STACK_DEPTH) {
+        calls.push_back(opcode & 0x0FFFu);
+      }
+      break;
+
+    case 0xD: {
+      // Same rows as Op_Dxyn: all n when the profile wraps sprites, else
+      // the ones below the screen are clipped and not read
+      unsigned int rows = opcode & 0x000Fu;
+      unsigned int y = chip8.registers8_16[(opcode & 0x00F0u) >> 4u];
+      bool wrap = false;
+
+      WithQuirks(chip8.Quirks(), [&wrap](auto policy) {
+        wrap = decltype(policy)::WRAP_SPRITES;
+      });
+
+      if (!wrap) {
+        rows = std::min<unsigned int>(rows, VIDEO_HEIGHT - y % VIDEO_HEIGHT);
+      }
+
+      Count(reads, rows);
+    } break;
+
+    case 0xF:
+      if ((opcode & 0x00FFu) == 0x33) Count(writes, 3);
+      if ((opcode & 0x00FFu) == 0x55) Count(writes, x + 1);
+      if ((opcode & 0x00FFu) == 0x65) Count(reads, x + 1);
+      break;
+  }
+}
+
+void GuestProfiler::SyncCalls() {
+  // 00EE pops, and anything else that moves sp8 (LoadState, a stack
+  // underflow) leaves frames we can't name
+  std::size_t depth = std::min<std::size_t>(chip8.sp8, STACK_DEPTH);
+
+  calls.resize(depth, UNKNOWN_ENTRY);
+}
+
+std::string GuestProfiler::Symbol(uint16_t pc) const {
+  char text[16];
+  std::snprintf(text, sizeof(text), "%03X: ", pc);
+
+  uint16_t opcode = (image[pc] << 8u) | image[(pc + 1) % MEMORY_SIZE];
+  return text + Disassemble(opcode);
+}
+
+void GuestProfiler::WriteFoldedStacks(std::ostream& out) const {
+  for (auto const& entry : stacks) {
+    std::vector<uint16_t> const& stack = entry.first;
+
+    out << "main";
+
+    for (std::size_t i = 0; i + 1 < stack.size(); ++i) {
+      char frame[16];
+
+      if (stack[i] == UNKNOWN_ENTRY) {
+        std::snprintf(frame, sizeof(frame), ";sub_unknown");
+      } else {
+        std::snprintf(frame, sizeof(frame), ";sub_%03X", stack[i]);
+      }
+
+      out << frame;
+    }
+
+    out << ";" << Symbol(stack.back()) << " " << entry.second << "\n";
+  }
+}
+
+void GuestProfiler::WriteHeatmap(std::ostream& out) const {
+  out << "address,fetches,reads,writes\n";
+
+  for (unsigned int address = 0; address < MEMORY_SIZE; ++address) {
+    if (fetches[address] == 0 && reads[address] == 0 &&
+        writes[address] == 0) {
+      continue;
+    }
+
+    char text[8];
+    std::snprintf(text, sizeof(text), "0x%03X", address);
+
+    out << text << "," << fetches[address] << "," << reads[address] << ","
+        << writes[address] << "\n";
+  }
+}
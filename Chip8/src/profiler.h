@@ -0,0 +1,66 @@
+#ifndef CHIP8_PROFILER_H
+
+#define CHIP8_PROFILER_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "chip_8.h"
+
+const unsigned int PROFILE_DEFAULT_PERIOD = 97;  // prime -> no lock-step
+                                                 // with short ROM loops
+
+// Runs a Chip8 on the table core one instruction at a time and watches it:
+// - every `period` instructions, samples pc16 with the guest call stack
+//   (entry points of the active subroutines, pushed/popped in step with
+//   the 2nnn/00EE pushes and pops on stack16_16)
+// - every instruction, counts fetches, data reads (Dxyn, Fx65) and data
+//   writes (Fx33, Fx55) per byte of memory8_4kb
+// Symbols come from a disassembly of memory as it was when profiling
+// started (the loaded ROM): "main" for the top level, "sub_XXX" for a
+// subroutine entered at 0xXXX, "XXX: <instruction>" for a sampled pc.
+class GuestProfiler {
+ public:
+  explicit GuestProfiler(Chip8& chip8,
+                         unsigned int period = PROFILE_DEFAULT_PERIOD);
+
+  void Cycle();                               // like Chip8::Cycle()
+  void StepFrame(unsigned int instructions);  // like Chip8::StepFrame()
+
+  uint64_t Instructions() const { return instructions; }
+  uint64_t Samples() const { return samples; }
+
+  // One line per distinct stack, "main;sub_2A4;2B0: DRW V0, V1, 5 123"
+  // -> flamegraph.pl, inferno, speedscope
+  void WriteFoldedStacks(std::ostream& out) const;
+
+  // CSV "address,fetches,reads,writes", one row per byte ever touched
+  void WriteHeatmap(std::ostream& out) const;
+
+ private:
+  void Account(uint16_t pc, uint16_t opcode);  // before the instruction
+  void SyncCalls();                             // after it
+  std::string Symbol(uint16_t pc) const;
+
+  Chip8& chip8;
+  unsigned int period;
+  unsigned int until_sample;
+
+  std::vector<uint8_t> image;   // memory8_4kb when profiling started
+  std::vector<uint16_t> calls;  // subroutine entries, outermost first
+
+  // calls + sampled pc -> number of samples
+  std::map<std::vector<uint16_t>, uint64_t> stacks;
+
+  std::vector<uint64_t> fetches;  // per byte of memory8_4kb
+  std::vector<uint64_t> reads;
+  std::vector<uint64_t> writes;
+
+  uint64_t instructions{};
+  uint64_t samples{};
+};
+
+#endif  // CHIP8_PROFILER_H
@@ -0,0 +1,40 @@
+#include "quirks.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+char const* QuirkProfileName(QuirkProfile profile) {
+  switch (profile) {
+    case QUIRKS_DEFAULT: return "default";
+    case QUIRKS_COSMAC: return "cosmac";
+    case QUIRKS_SCHIP: return "schip";
+    case QUIRKS_XOCHIP: return "xochip";
+  }
+
+  return "unknown";
+}
+
+bool ParseQuirkProfile(char const* name, QuirkProfile& profile) {
+  for (QuirkProfile candidate : ALL_QUIRK_PROFILES) {
+    if (std::strcmp(name, QuirkProfileName(candidate)) == 0) {
+      profile = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+QuirkProfile QuirksForRom(char const* rom_file) {
+  std::ifstream in(std::string(rom_file) + ".quirks");
+  std::string name;
+  QuirkProfile profile = QUIRKS_DEFAULT;
+
+  // No file, or a name we don't know -> default
+  if (in >> name) {
+    ParseQuirkProfile(name.c_str(), profile);
+  }
+
+  return profile;
+}
@@ -0,0 +1,73 @@
+#ifndef CHIP8_QUIRKS_H
+
+#define CHIP8_QUIRKS_H
+
+#include <cstdint>
+
+// Behaviours CHIP-8 interpreters disagree on. A handler templated on a
+// policy reads them as constants -> every instantiation has its quirk
+// branches resolved at compile time
+template <bool ShiftVy, bool LoadStoreIncrementsI, bool JumpVx,
+          bool WrapSprites, bool LogicResetsVf>
+struct QuirkPolicy {
+  // 8xy6/8xyE: Vx = Vy >> 1 / Vy << 1 (else Vx shifted in place)
+  static constexpr bool SHIFT_VY = ShiftVy;
+
+  // Fx55/Fx65: index16 += x + 1 afterwards (else index16 unchanged)
+  static constexpr bool LOAD_STORE_INCREMENTS_I = LoadStoreIncrementsI;
+
+  // Bxnn: jump to xnn + Vx (else Bnnn: nnn + V0)
+  static constexpr bool JUMP_VX = JumpVx;
+
+  // Dxyn: sprites wrap around the edges (else clipped)
+  static constexpr bool WRAP_SPRITES = WrapSprites;
+
+  // 8xy1/8xy2/8xy3: VF = 0 afterwards
+  static constexpr bool LOGIC_RESETS_VF = LogicResetsVf;
+};
+
+// Cowgod's reference / Austin Morlan: what Chip8 always did
+typedef QuirkPolicy<false, false, false, false, false> DefaultQuirks;
+
+// COSMAC VIP, the original interpreter
+typedef QuirkPolicy<true, true, false, false, true> CosmacQuirks;
+
+// SUPER-CHIP 1.1 (HP-48)
+typedef QuirkPolicy<false, false, true, false, false> SuperChipQuirks;
+
+// XO-CHIP, as Octo runs it
+typedef QuirkPolicy<true, true, false, true, false> XoChipQuirks;
+
+// Runtime name for a policy: what a ROM selects, what Chip8 stores
+enum QuirkProfile : uint8_t {
+  QUIRKS_DEFAULT,  // DefaultQuirks
+  QUIRKS_COSMAC,   // CosmacQuirks
+  QUIRKS_SCHIP,    // SuperChipQuirks
+  QUIRKS_XOCHIP,   // XoChipQuirks
+};
+
+const QuirkProfile ALL_QUIRK_PROFILES[] = {QUIRKS_DEFAULT, QUIRKS_COSMAC,
+                                           QUIRKS_SCHIP, QUIRKS_XOCHIP};
+
+// "default", "cosmac", "schip", "xochip"
+char const* QuirkProfileName(QuirkProfile profile);
+bool ParseQuirkProfile(char const* name, QuirkProfile& profile);  // false if
+                                                                  // unknown
+
+// A ROM's profile: the name in `<ROM>.quirks` next to it (e.g.
+// "Tetris.ch8.quirks" holding "cosmac"), else QUIRKS_DEFAULT
+QuirkProfile QuirksForRom(char const* rom_file);
+
+// function(Policy{}) with the policy type of `profile`: one switch, then
+// code instantiated for that policy
+template <typename Function>
+void WithQuirks(QuirkProfile profile, Function&& function) {
+  switch (profile) {
+    case QUIRKS_COSMAC: function(CosmacQuirks{}); break;
+    case QUIRKS_SCHIP: function(SuperChipQuirks{}); break;
+    case QUIRKS_XOCHIP: function(XoChipQuirks{}); break;
+    default: function(DefaultQuirks{}); break;
+  }
+}
+
+#endif  // CHIP8_QUIRKS_H
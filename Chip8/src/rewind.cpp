@@ -0,0 +1,192 @@
+#include "rewind.h"
+
+#include <algorithm>
+#include <cstring>
+
+const std::size_t STATE_SIZE = sizeof(Chip8State);
+
+// Literal runs only end at this many equal bytes -> a run header (4 bytes)
+// always pays for itself and no record exceeds REWIND_MAX_RECORD
+const std::size_t MIN_ZERO_RUN = 4;
+
+static_assert(STATE_SIZE <= 0xFFFF, "run lengths are stored as uint16");
+
+static void PutU16(uint8_t* out, std::size_t value) {
+  out[0] = value & 0xFFu;
+  out[1] = (value >> 8u) & 0xFFu;
+}
+
+static std::size_t GetU16(uint8_t const* in) { return in[0] | (in[1] << 8u); }
+
+RewindBuffer::RewindBuffer(std::size_t capacity,
+                           unsigned int keyframe_interval)
+    : ring(std::max(capacity, 2 * REWIND_MAX_RECORD)),
+      keyframe_interval(std::max(keyframe_interval, 1u)) {}
+
+void RewindBuffer::Clear() {
+  records.clear();
+  bytes_used = 0;
+  head = 0;
+  since_key = 0;
+}
+
+// Record layout: (skip u16, count u16, count XOR bytes)... -> skip `skip`
+// unchanged bytes, then XOR the next `count`; unchanged tail is implicit
+std::size_t RewindBuffer::Encode(uint8_t const* a, uint8_t const* b,
+                                 uint8_t* encoded) {
+  std::size_t size = 0;
+  std::size_t pos = 0;
+
+  while (pos < STATE_SIZE) {
+    std::size_t run_start = pos;
+
+    while (pos < STATE_SIZE && a[pos] == b[pos]) {
+      ++pos;
+    }
+
+    if (pos == STATE_SIZE) {
+      break;
+    }
+
+    std::size_t literal_start = pos;
+    std::size_t literal_end = pos;
+    std::size_t equal = 0;
+
+    for (; pos < STATE_SIZE && equal < MIN_ZERO_RUN; ++pos) {
+      if (a[pos] == b[pos]) {
+        ++equal;
+      } else {
+        equal = 0;
+        literal_end = pos + 1;
+      }
+    }
+
+    pos = literal_end;
+
+    PutU16(encoded + size, literal_start - run_start);
+    PutU16(encoded + size + 2, literal_end - literal_start);
+    size += 4;
+
+    for (std::size_t i = literal_start; i < literal_end; ++i) {
+      encoded[size++] = a[i] ^ b[i];
+    }
+  }
+
+  return size;
+}
+
+void RewindBuffer::Apply(Record const& record, Chip8State& state) const {
+  uint8_t* bytes = reinterpret_cast<uint8_t*>(&state);
+  uint8_t const* in = ring.data() + record.offset;
+  uint8_t const* end = in + record.size;
+  std::size_t pos = 0;
+
+  while (in < end) {
+    pos += GetU16(in);
+    std::size_t count = GetU16(in + 2);
+    in += 4;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      bytes[pos++] ^= *in++;
+    }
+  }
+}
+
+void RewindBuffer::EvictOldestGroup() {
+  do {
+    bytes_used -= records.front().size;
+    records.pop_front();
+  } while (!records.empty() && !records.front().key);
+}
+
+// The front record is a keyframe (never empty) -> its offset is the tail,
+// and head == tail with records left means full, not empty
+std::size_t RewindBuffer::Reserve(std::size_t size) {
+  while (!records.empty()) {
+    std::size_t tail = records.front().offset;
+
+    if (head > tail) {
+      // Used: [tail, head) -> free at the end, or from 0 after wrapping
+      if (head + size <= ring.size()) {
+        return head;
+      }
+
+      if (size <= tail) {
+        return 0;
+      }
+    } else if (head + size <= tail) {
+      return head;  // wrapped: free is [head, tail)
+    }
+
+    EvictOldestGroup();
+  }
+
+  head = 0;
+  return 0;
+}
+
+void RewindBuffer::Push(Chip8 const& chip8) {
+  static uint8_t const ZEROS[STATE_SIZE] = {};
+
+  Chip8State const& state = chip8;
+  uint8_t const* now = reinterpret_cast<uint8_t const*>(&state);
+
+  bool key = records.empty() || since_key + 1 >= keyframe_interval;
+  std::size_t size = Encode(
+      now, key ? ZEROS : reinterpret_cast<uint8_t const*>(&latest),
+      scratch.data());
+  // Unchanged frame (e.g. halted, timers at 0) -> empty delta, no bytes
+  std::size_t offset = size == 0 ? head : Reserve(size);
+
+  if (records.empty() && !key) {
+    // Eviction took this frame's whole group -> start a new one here
+    key = true;
+    size = Encode(now, ZEROS, scratch.data());
+  }
+
+  std::memcpy(ring.data() + offset, scratch.data(), size);
+  records.push_back({offset, size, key});
+  head = offset + size;
+  bytes_used += size;
+
+  since_key = key ? 0 : since_key + 1;
+  std::memcpy(&latest, &state, STATE_SIZE);
+}
+
+bool RewindBuffer::StepBack(Chip8& chip8) {
+  if (records.size() < 2) {
+    return false;
+  }
+
+  Record newest = records.back();
+  records.pop_back();
+  bytes_used -= newest.size;
+
+  if (newest.size != 0) {
+    head = newest.offset;  // its bytes are free again
+  }
+
+  if (!newest.key) {
+    // XOR is its own inverse -> one delta takes us back one frame
+    Apply(newest, latest);
+    --since_key;
+  } else {
+    // Crossed a keyframe -> rebuild from the previous one (bounded by K)
+    std::size_t key = records.size() - 1;
+
+    while (!records[key].key) {
+      --key;
+    }
+
+    latest = Chip8State{};  // what keyframes were XORed against
+
+    for (std::size_t i = key; i < records.size(); ++i) {
+      Apply(records[i], latest);
+    }
+
+    since_key = records.size() - 1 - key;
+  }
+
+  chip8.LoadState(latest);
+  return true;
+}
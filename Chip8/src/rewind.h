@@ -0,0 +1,65 @@
+#ifndef CHIP8_REWIND_H
+
+#define CHIP8_REWIND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "chip_8.h"
+
+const unsigned int REWIND_KEYFRAME_INTERVAL = 60;  // one keyframe a second
+const std::size_t REWIND_DEFAULT_CAPACITY = 4 * 1024 * 1024;  // bytes
+
+// Worst-case encoded frame: one run header, then every byte as a literal
+const std::size_t REWIND_MAX_RECORD = sizeof(Chip8State) + 8;
+
+// Per-frame history of a Chip8 in a fixed-size byte ring. Every
+// `keyframe_interval` frames a keyframe stores the whole Chip8State; the
+// frames in between store the XOR with the previous frame, run-length
+// encoded (most bytes don't change from one frame to the next, so most of
+// the XOR is zero runs). Push() evicts whole keyframe groups from the old
+// end when the ring is full. StepBack() undoes the newest frame: one delta
+// to decode, or at most `keyframe_interval` when it crosses a keyframe.
+class RewindBuffer {
+ public:
+  explicit RewindBuffer(std::size_t capacity = REWIND_DEFAULT_CAPACITY,
+                        unsigned int keyframe_interval =
+                            REWIND_KEYFRAME_INTERVAL);
+
+  void Push(Chip8 const& chip8);  // record the current frame
+  bool StepBack(Chip8& chip8);    // load the frame before the newest one
+  void Clear();
+
+  std::size_t Frames() const { return records.size(); }
+  std::size_t BytesUsed() const { return bytes_used; }
+  std::size_t Capacity() const { return ring.size(); }
+
+ private:
+  struct Record {
+    std::size_t offset;  // into `ring`
+    std::size_t size;
+    bool key;  // XOR against zeros (full state) instead of the last frame
+  };
+
+  std::size_t Reserve(std::size_t size);  // ring offset, evicts as needed
+  void EvictOldestGroup();
+
+  // Encode a ^ b into `encoded`; apply a record with `state` ^= record
+  std::size_t Encode(uint8_t const* a, uint8_t const* b, uint8_t* encoded);
+  void Apply(Record const& record, Chip8State& state) const;
+
+  std::vector<uint8_t> ring;
+  std::deque<Record> records;  // oldest first; front is always a keyframe
+  std::size_t bytes_used{};
+  std::size_t head{};  // next free offset; == the front's offset -> full
+
+  unsigned int keyframe_interval;
+  unsigned int since_key{};  // records after the newest keyframe
+
+  Chip8State latest{};  // state of the newest record
+  std::vector<uint8_t> scratch = std::vector<uint8_t>(REWIND_MAX_RECORD);
+};
+
+#endif  // CHIP8_REWIND_H
@@ -0,0 +1,135 @@
+#include "rom_cache.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t HashRom(uint8_t const* data, std::size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+// Map `path` read-only, check its size, copy it into `image`, unmap. The
+// mapping only lives for the copy: an image is at most a few KB and
+// memory8_4kb sits inside each Chip8, so the copy is needed anyway.
+#if defined(_WIN32)
+static bool MapRom(char const* path, std::size_t max_size,
+                   RomImage& image) {
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size{};
+  bool ok = GetFileSizeEx(file, &size) &&
+            size.QuadPart <= static_cast<LONGLONG>(max_size);
+
+  // Empty file -> nothing to map (CreateFileMapping refuses size 0)
+  if (ok && size.QuadPart > 0) {
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void const* view = mapping != nullptr
+                           ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                           : nullptr;
+
+    ok = view != nullptr;
+
+    if (ok) {
+      auto begin = static_cast<uint8_t const*>(view);
+      image.bytes.assign(begin, begin + size.QuadPart);
+      UnmapViewOfFile(view);
+    }
+
+    if (mapping != nullptr) {
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+  return ok;
+}
+#else
+static bool MapRom(char const* path, std::size_t max_size,
+                   RomImage& image) {
+  int file = open(path, O_RDONLY);
+
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat info {};
+  bool ok = fstat(file, &info) == 0 && S_ISREG(info.st_mode) &&
+            info.st_size <= static_cast<off_t>(max_size);
+
+  // Empty file -> nothing to map (mmap refuses length 0)
+  if (ok && info.st_size > 0) {
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ok = view != MAP_FAILED;
+
+    if (ok) {
+      auto begin = static_cast<uint8_t const*>(view);
+      image.bytes.assign(begin, begin + info.st_size);
+      munmap(view, info.st_size);
+    }
+  }
+
+  close(file);
+  return ok;
+}
+#endif
+
+RomCache& RomCache::Global() {
+  static RomCache cache;
+  return cache;
+}
+
+std::shared_ptr<RomImage const> RomCache::Load(char const* path,
+                                               std::size_t max_size) {
+  std::lock_guard<std::mutex> guard(lock);
+
+  auto known = by_path.find(path);
+
+  if (known != by_path.end()) {
+    return known->second->bytes.size() <= max_size ? known->second : nullptr;
+  }
+
+  auto image = std::make_shared<RomImage>();
+
+  if (!MapRom(path, max_size, *image)) {
+    return nullptr;
+  }
+
+  image->hash = HashRom(image->bytes.data(), image->bytes.size());
+  image->quirks = QuirksForRom(path);
+
+  // Same bytes + profile under another path -> share that image. Compare
+  // the bytes too: a hash collision must not swap one ROM for another
+  auto same = by_hash.find(image->hash);
+
+  if (same != by_hash.end() && same->second->bytes == image->bytes &&
+      same->second->quirks == image->quirks) {
+    return by_path[path] = same->second;
+  }
+
+  by_hash.emplace(image->hash, image);
+  ++images;
+  return by_path[path] = image;
+}
+
+std::size_t RomCache::Size() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return images;
+}
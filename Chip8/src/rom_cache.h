@@ -0,0 +1,47 @@
+#ifndef CHIP8_ROM_CACHE_H
+
+#define CHIP8_ROM_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "chip_8.h"
+
+uint64_t HashRom(uint8_t const* data, std::size_t size);  // FNV-1a 64
+
+// A ROM file's contents, loaded @START_ADDRESS by Chip8::LoadRom(RomImage
+// const&) (or the XO-CHIP machine's, which takes larger ones)
+struct RomImage {
+  uint64_t hash{};  // HashRom() of the bytes (FNV-1a 64)
+  std::vector<uint8_t> bytes;
+  QuirkProfile quirks{QUIRKS_DEFAULT};  // QuirksForRom() of its path
+};
+
+// Process-wide ROM store, safe to share between threads. A path is read
+// once (memory-mapped, size-checked, hashed, its .quirks sidecar read);
+// images are shared by content + profile, so every instance of a ROM -
+// under any path - copies from one image.
+// Nothing is evicted or re-read -> a ROM edited on disk needs a new process.
+class RomCache {
+ public:
+  static RomCache& Global();
+
+  // nullptr if the file can't be mapped or is over `max_size` bytes
+  std::shared_ptr<RomImage const> Load(char const* path,
+                                       std::size_t max_size = MAX_ROM_SIZE);
+
+  std::size_t Size() const;  // distinct images
+
+ private:
+  mutable std::mutex lock;
+  std::unordered_map<std::string, std::shared_ptr<RomImage const>> by_path;
+  std::unordered_map<uint64_t, std::shared_ptr<RomImage const>> by_hash;
+  std::size_t images{};
+};
+
+#endif  // CHIP8_ROM_CACHE_H
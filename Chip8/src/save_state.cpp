@@ -0,0 +1,72 @@
+#include "save_state.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Chip8State>::value,
+              "Chip8State must stay a plain block of bytes");
+
+static const char SAVE_STATE_MAGIC[4] = {'C', '8', 'S', 'S'};
+
+bool SaveStateToBuffer(Chip8 const& chip8, uint8_t* buffer, std::size_t size) {
+  if (size < SAVE_STATE_SIZE) {
+    return false;
+  }
+
+  SaveStateHeader header;
+  std::memcpy(header.magic, SAVE_STATE_MAGIC, sizeof(header.magic));
+  header.version = SAVE_STATE_VERSION;
+  header.size = sizeof(Chip8State);
+
+  std::memcpy(buffer, &header, sizeof(header));
+  std::memcpy(buffer + sizeof(header), static_cast<Chip8State const*>(&chip8),
+              sizeof(Chip8State));
+
+  return true;
+}
+
+bool LoadStateFromBuffer(Chip8& chip8, uint8_t const* buffer,
+                         std::size_t size) {
+  if (size < SAVE_STATE_SIZE) {
+    return false;
+  }
+
+  SaveStateHeader header;
+  std::memcpy(&header, buffer, sizeof(header));
+
+  if (std::memcmp(header.magic, SAVE_STATE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SAVE_STATE_VERSION ||
+      header.size != sizeof(Chip8State)) {
+    return false;
+  }
+
+  Chip8State state;
+  std::memcpy(&state, buffer + sizeof(header), sizeof(state));
+  chip8.LoadState(state);
+
+  return true;
+}
+
+bool SaveStateToFile(Chip8 const& chip8, char const* file) {
+  uint8_t buffer[SAVE_STATE_SIZE];
+  SaveStateToBuffer(chip8, buffer, sizeof(buffer));
+
+  std::ofstream out(file, std::ios::binary);
+  out.write(reinterpret_cast<char const*>(buffer), sizeof(buffer));
+
+  return static_cast<bool>(out);
+}
+
+bool LoadStateFromFile(Chip8& chip8, char const* file) {
+  uint8_t buffer[SAVE_STATE_SIZE];
+
+  std::ifstream in(file, std::ios::binary);
+  in.read(reinterpret_cast<char*>(buffer), sizeof(buffer));
+
+  if (in.gcount() != static_cast<std::streamsize>(sizeof(buffer))) {
+    return false;
+  }
+
+  return LoadStateFromBuffer(chip8, buffer, sizeof(buffer));
+}
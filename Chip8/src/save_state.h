@@ -0,0 +1,33 @@
+#ifndef CHIP8_SAVE_STATE_H
+
+#define CHIP8_SAVE_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chip_8.h"
+
+// Bump whenever Chip8State changes layout
+const uint32_t SAVE_STATE_VERSION = 2;  // 2: key_wait8
+
+// Serialized snapshot: this header, then the raw Chip8State bytes (host
+// layout/endianness -> for checkpoints on the same build, not an archive)
+struct SaveStateHeader {
+  char magic[4];     // "C8SS"
+  uint32_t version;  // SAVE_STATE_VERSION
+  uint32_t size;     // sizeof(Chip8State)
+};
+
+const std::size_t SAVE_STATE_SIZE =
+    sizeof(SaveStateHeader) + sizeof(Chip8State);
+
+// Buffer versions: `size` must be at least SAVE_STATE_SIZE. Loading rejects
+// other magic/versions/sizes and leaves the Chip8 untouched
+bool SaveStateToBuffer(Chip8 const& chip8, uint8_t* buffer, std::size_t size);
+bool LoadStateFromBuffer(Chip8& chip8, uint8_t const* buffer,
+                         std::size_t size);
+
+bool SaveStateToFile(Chip8 const& chip8, char const* file);
+bool LoadStateFromFile(Chip8& chip8, char const* file);
+
+#endif  // CHIP8_SAVE_STATE_H
@@ -0,0 +1,79 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+// 1 s in ns == one frame in (ns * TIMER_HZ) units
+const int64_t SCALED_NS_PER_FRAME = 1000000000;
+
+Scheduler::Scheduler(Chip8& chip8, unsigned int instructions_per_frame)
+    : chip8(chip8), instructions_per_frame(instructions_per_frame) {}
+
+void Scheduler::RunFrame() {
+  if (Uncapped()) {
+    // No per-frame budget -> a frame is just the timer tick (the bursts
+    // before it all count as the start of the frame for audio)
+    if (synth != nullptr) {
+      synth->Track(chip8.sound_timer8 != 0, 0, 1);
+    }
+
+    chip8.TickTimers();
+
+    if (synth != nullptr) {
+      synth->EndFrame(chip8.sound_timer8 != 0);
+    }
+  } else {
+    // What the frame ran: less than the budget once halted in Fx0A
+    instructions += synth != nullptr
+                        ? StepFrameWithAudio(chip8, instructions_per_frame,
+                                             *synth)
+                        : chip8.StepFrame(instructions_per_frame);
+  }
+
+  ++frames;
+}
+
+unsigned int Scheduler::Advance(std::chrono::nanoseconds elapsed) {
+  owed_scaled_ns += elapsed.count() * TIMER_HZ;
+
+  if (Uncapped()) {
+    // Free-run a burst; the caller comes back as soon as we return (and
+    // sleeps instead while halted or idle, see UntilNextFrame())
+    unsigned int i = 0;
+    uint64_t skipped = chip8.idle_skipped;
+
+    for (; i < UNCAPPED_BURST && !chip8.Halted(); ++i) {
+      chip8.Cycle();
+      i += chip8.SkipIdle(UNCAPPED_BURST - i - 1);
+    }
+
+    instructions += i;
+
+    // An idle loop stays one until the next timer tick or key change
+    idle = chip8.idle_skipped != skipped;
+  }
+
+  unsigned int ran = 0;
+
+  while (owed_scaled_ns >= SCALED_NS_PER_FRAME) {
+    owed_scaled_ns -= SCALED_NS_PER_FRAME;
+
+    if (ran == MAX_CATCH_UP_FRAMES) {
+      // Host fell behind (window drag, debugger...) -> skip, don't spiral
+      dropped_frames += owed_scaled_ns / SCALED_NS_PER_FRAME + 1;
+      owed_scaled_ns %= SCALED_NS_PER_FRAME;
+      break;
+    }
+
+    RunFrame();
+    ++ran;
+  }
+
+  return ran;
+}
+
+std::chrono::nanoseconds Scheduler::UntilNextFrame() const {
+  int64_t scaled = std::max<int64_t>(SCALED_NS_PER_FRAME - owed_scaled_ns, 0);
+
+  // Round up -> waking at the deadline always finds the frame due
+  return std::chrono::nanoseconds((scaled + TIMER_HZ - 1) / TIMER_HZ);
+}
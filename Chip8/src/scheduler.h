@@ -0,0 +1,60 @@
+#ifndef CHIP8_SCHEDULER_H
+
+#define CHIP8_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "audio.h"
+#include "chip_8.h"
+
+const unsigned int DEFAULT_INSTRUCTIONS_PER_FRAME = 10;  // 600 IPS @ 60 Hz
+const unsigned int UNCAPPED = 0;         // IPF value: CPU free-runs
+const unsigned int UNCAPPED_BURST = 1000;  // instrucns per Advance() uncapped
+const unsigned int MAX_CATCH_UP_FRAMES = 4;  // after a host stall, drop rest
+
+// Turns host time into whole 60 Hz frames of emulated time. Each frame runs
+// `instructions_per_frame` instructions and then ticks the timers once, so the
+// CPU rate can be raised without changing game speed. With UNCAPPED the CPU
+// runs as fast as the host allows and only the timers follow host time.
+class Scheduler {
+ public:
+  Scheduler(Chip8& chip8, unsigned int instructions_per_frame);
+
+  void RunFrame();  // one frame now, regardless of host time
+
+  // Every frame from now on also feeds `synth` (nullptr -> silent again)
+  void SetAudio(AudioSynth* audio) { synth = audio; }
+
+  // Credit `elapsed` host time, run every frame that is now due; returns the
+  // number of frames run (0 = nothing to present)
+  unsigned int Advance(std::chrono::nanoseconds elapsed);
+
+  // Host time still to credit before the next frame is due
+  std::chrono::nanoseconds UntilNextFrame() const;
+
+  bool Uncapped() const { return instructions_per_frame == UNCAPPED; }
+  unsigned int InstructionsPerFrame() const { return instructions_per_frame; }
+  uint64_t Frames() const { return frames; }
+  uint64_t Instructions() const { return instructions; }
+  uint64_t DroppedFrames() const { return dropped_frames; }
+
+  // Uncapped: the last burst ended in an idle loop (Chip8::SkipIdle)
+  bool Idle() const { return idle; }
+
+ private:
+  Chip8& chip8;
+  unsigned int instructions_per_frame;
+  AudioSynth* synth{};
+
+  // Host time owed, scaled by TIMER_HZ so one frame is exactly 1e9 units
+  // (1/60 s is not a whole number of nanoseconds)
+  int64_t owed_scaled_ns{};
+
+  uint64_t frames{};
+  uint64_t instructions{};
+  uint64_t dropped_frames{};
+  bool idle{};
+};
+
+#endif  // CHIP8_SCHEDULER_H
@@ -0,0 +1,82 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <iomanip>
+
+// Same numbering as the handler declarations in chip_8.h
+static char const* const HANDLER_NAMES[STATS_HANDLERS] = {
+    "NULL", "00E0", "00EE", "1nnn", "2nnn", "3xnn", "4xnn", "5xy0", "6xnn",
+    "7xnn", "8xy0", "8xy1", "8xy2", "8xy3", "8xy4", "8xy5", "8xy6", "8xy7",
+    "8xyE", "9xy0", "Annn", "Bnnn", "Cxnn", "Dxyn", "Ex9E", "ExA1", "Fx07",
+    "Fx0A", "Fx15", "Fx18", "Fx1E", "Fx29", "Fx33", "Fx55", "Fx65"};
+
+void ExecCounts::Add(ExecCounts const& other) {
+  for (unsigned int i = 0; i < STATS_HANDLERS; ++i) {
+    handlers[i] += other.handlers[i];
+  }
+
+  table0 += other.table0;
+  table8 += other.table8;
+  tableE += other.tableE;
+  tableF += other.tableF;
+  collisions += other.collisions;
+  key_waits += other.key_waits;
+  idle_skipped += other.idle_skipped;
+}
+
+uint64_t ExecCounts::Instructions() const {
+  uint64_t total = 0;
+
+  for (uint64_t count : handlers) {
+    total += count;
+  }
+
+  return total;
+}
+
+uint64_t ExecCounts::Retired() const { return Instructions() + idle_skipped; }
+
+void ExecStats::EndFrame() {
+  uint64_t instructions = counts.Retired();
+  uint64_t frame_instructions = instructions - frame_start;
+
+  min_frame_instructions = std::min(min_frame_instructions, frame_instructions);
+  max_frame_instructions = std::max(max_frame_instructions, frame_instructions);
+  frame_start = instructions;
+  ++frames;
+}
+
+void DumpStats(ExecStats const& stats, std::ostream& out) {
+  ExecCounts const& counts = stats.counts;
+  uint64_t instructions = counts.Instructions();
+  double total = instructions > 0 ? instructions : 1;
+
+  out << "instructions: " << instructions << "\n"
+      << "idle skipped: " << counts.idle_skipped << "\n";
+
+  for (unsigned int i = 0; i < STATS_HANDLERS; ++i) {
+    if (counts.handlers[i] == 0) {
+      continue;
+    }
+
+    out << "  " << HANDLER_NAMES[i] << "  " << std::setw(14)
+        << counts.handlers[i] << "  " << std::fixed << std::setprecision(2)
+        << std::setw(6) << 100.0 * counts.handlers[i] / total << "%\n"
+        << std::defaultfloat;
+  }
+
+  out << "sub-dispatch: table0 " << counts.table0 << ", table8 "
+      << counts.table8 << ", tableE " << counts.tableE << ", tableF "
+      << counts.tableF << "\n"
+      << "Op_NULL hits: " << counts.handlers[0] << "\n"
+      << "Dxyn collisions: " << counts.collisions << "\n"
+      << "Fx0A waits: " << counts.key_waits << "\n"
+      << "frames: " << stats.frames << "\n";
+
+  if (stats.frames > 0) {
+    // Idle-skipped passes count: a frame reports its whole budget
+    out << "instructions/frame: min " << stats.min_frame_instructions
+        << ", mean " << stats.frame_start / stats.frames << ", max "
+        << stats.max_frame_instructions << "\n";
+  }
+}
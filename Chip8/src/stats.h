@@ -0,0 +1,51 @@
+#ifndef CHIP8_STATS_H
+
+#define CHIP8_STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+// Build with CHIP8_STATS=1 to count what a ROM executes. Off by default:
+// the counters and every update compile out, Chip8 keeps its layout
+#ifndef CHIP8_STATS
+#define CHIP8_STATS 0
+#endif
+
+const unsigned int STATS_HANDLERS = 35;  // Op_NULL (00) to Op_Fx65 (34)
+
+// What the dispatch and the Op_* handlers count
+struct ExecCounts {
+  uint64_t handlers[STATS_HANDLERS]{};  // by number, see chip_8.h
+  uint64_t table0{};                    // sub-dispatches
+  uint64_t table8{};
+  uint64_t tableE{};
+  uint64_t tableF{};
+  uint64_t collisions{};  // Dxyn that set Vf
+  uint64_t key_waits{};   // Fx0A with no key down (CPU halted)
+  uint64_t idle_skipped{};  // idle-loop passes skipped (Chip8::SkipIdle)
+
+  void Add(ExecCounts const& other);
+  uint64_t Instructions() const;  // every handler call = one instruction
+  uint64_t Retired() const;  // Instructions() + idle_skipped
+};
+
+// Per-Chip8 totals. Counted by the table core (Chip8::Cycle); the other
+// cores only reach the Op_* handlers they delegate to -> profile with the
+// table core
+struct ExecStats {
+  ExecCounts counts;
+
+  // Instructions retired (run or idle-skipped) between two TickTimers()
+  uint64_t frames{};
+  uint64_t frame_start{};  // counts.Retired() at the last tick
+  uint64_t min_frame_instructions{UINT64_MAX};
+  uint64_t max_frame_instructions{};
+
+  void EndFrame();
+};
+
+// Human-readable dump: every handler that ran (Op_NULL = undecoded or
+// invalid opcodes), sub-dispatches, and the frame statistics
+void DumpStats(ExecStats const& stats, std::ostream& out);
+
+#endif  // CHIP8_STATS_H
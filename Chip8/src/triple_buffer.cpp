@@ -0,0 +1,41 @@
+#include "triple_buffer.h"
+
+#include <algorithm>
+
+double HandoffStats::MeanLatencyUs() const {
+  return frames > 0 ? total_latency_ns / 1000.0 / frames : 0.0;
+}
+
+void TripleBuffer::Publish(uint64_t const* rows) {
+  VideoFrame& frame = slots[back];
+
+  std::copy(rows, rows + VIDEO_HEIGHT, frame.rows);
+  frame.number = ++published;
+  frame.published = std::chrono::steady_clock::now();
+
+  // Release -> the consumer sees the whole frame once it sees the index
+  back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & SLOT_MASK;
+}
+
+VideoFrame const* TripleBuffer::Acquire() {
+  if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+    return nullptr;
+  }
+
+  uint64_t last = slots[front].number;
+
+  // Acquire -> pairs with Publish's release
+  front = middle.exchange(front, std::memory_order_acq_rel) & SLOT_MASK;
+
+  VideoFrame const& frame = slots[front];
+  int64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - frame.published)
+                           .count();
+
+  ++stats.frames;
+  stats.dropped += frame.number - last - 1;
+  stats.total_latency_ns += latency_ns;
+  stats.max_latency_ns = std::max(stats.max_latency_ns, latency_ns);
+
+  return &frame;
+}
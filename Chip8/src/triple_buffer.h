@@ -0,0 +1,59 @@
+#ifndef CHIP8_TRIPLE_BUFFER_H
+
+#define CHIP8_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "chip_8.h"
+
+// One finished 60 Hz frame, as handed from the emulation thread to the
+// render thread
+struct VideoFrame {
+  uint64_t rows[VIDEO_HEIGHT]{};  // copy of video64_32
+  uint64_t number{};  // 1, 2, 3... in publish order (0 = never written)
+  std::chrono::steady_clock::time_point published;
+};
+
+struct HandoffStats {
+  uint64_t frames{};   // frames acquired by the render thread
+  uint64_t dropped{};  // published but overwritten before being acquired
+  int64_t total_latency_ns{};  // sum of publish -> acquire
+  int64_t max_latency_ns{};
+
+  double MeanLatencyUs() const;
+};
+
+// Single-producer/single-consumer frame hand-off without locks: three slots,
+// one owned by each side and one in the middle. Publish() swaps the back
+// slot with the middle one, Acquire() swaps the middle slot with the front
+// one only when it holds a newer frame. Neither side ever waits for the
+// other; a slow consumer just skips to the newest frame.
+class TripleBuffer {
+ public:
+  // Producer (emulation thread): copy `rows` in, stamp and publish
+  void Publish(uint64_t const* rows);
+
+  // Consumer (render thread): newest frame since the last call, or nullptr
+  // if nothing new was published. Valid until the next Acquire()
+  VideoFrame const* Acquire();
+
+  HandoffStats const& Stats() const { return stats; }  // consumer side
+
+ private:
+  static constexpr uint8_t SLOT_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;  // middle holds an unread frame
+
+  // Each side's data on its own cache line -> no false sharing
+  alignas(64) VideoFrame slots[3];
+  alignas(64) std::atomic<uint8_t> middle{2};  // slot index | FRESH
+
+  alignas(64) uint8_t back{0};  // producer only
+  uint64_t published{};
+
+  alignas(64) uint8_t front{1};  // consumer only
+  HandoffStats stats;
+};
+
+#endif  // CHIP8_TRIPLE_BUFFER_H
@@ -0,0 +1,174 @@
+// BatchCore lanes against plain Chip8 machines, frame by frame: the sample
+// ROMs and random programs under every quirk profile, each lane with its own
+// seed and keys, once with the AVX2 lockstep path (where the CPU has it) and
+// once lane by lane. `make test` (from Chip8/); exit 1 on mismatch.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "batch_core.h"
+#include "chip_8.h"
+#include "quirks.h"
+#include "rom_cache.h"
+
+const unsigned int TEST_LANES = 37;  // a full block and a padded one
+const unsigned int TEST_FRAMES = 300;
+const unsigned int TEST_INSTRUCTIONS_PER_FRAME = 11;
+const unsigned int TEST_RANDOM_ROMS = 400;
+const unsigned int TEST_RANDOM_FRAMES = 30;
+
+static char const* const TEST_ROMS[] = {
+    "roms/sample_roms/IBM_Logo.ch8", "roms/sample_roms/Space_Invaders.ch8",
+    "roms/sample_roms/Tetris.ch8"};
+
+// Field by field: Chip8State has padding, so no memcmp of the whole struct
+static bool Same(Chip8State const& a, Chip8State const& b) {
+  return std::memcmp(a.registers8_16, b.registers8_16,
+                     sizeof(a.registers8_16)) == 0 &&
+         std::memcmp(a.memory8_4kb, b.memory8_4kb, sizeof(a.memory8_4kb)) ==
+             0 &&
+         a.index16 == b.index16 && a.pc16 == b.pc16 &&
+         std::memcmp(a.stack16_16, b.stack16_16, sizeof(a.stack16_16)) == 0 &&
+         a.sp8 == b.sp8 && a.delay_timer8 == b.delay_timer8 &&
+         a.sound_timer8 == b.sound_timer8 &&
+         std::memcmp(a.keypad8_16, b.keypad8_16, sizeof(a.keypad8_16)) == 0 &&
+         a.key_wait8 == b.key_wait8 &&
+         std::memcmp(a.video64_32, b.video64_32, sizeof(a.video64_32)) == 0 &&
+         a.opcode16 == b.opcode16 && a.random64 == b.random64;
+}
+
+// Mostly well-formed opcodes (jumps and calls inside the program) so lanes
+// share PCs and the lockstep path runs, with some raw words mixed in
+static RomImage RandomRom(std::mt19937& random) {
+  static uint8_t const FX_LOW[] = {0x07, 0x0A, 0x15, 0x18, 0x1E,
+                                   0x29, 0x33, 0x55, 0x65};
+  static uint16_t const ZERO_OPS[] = {0x00E0, 0x00EE, 0x0123};
+
+  RomImage rom;
+  unsigned int length = 20 + random() % 60;
+
+  for (unsigned int i = 0; i < length; ++i) {
+    uint16_t opcode = static_cast<uint16_t>(random());
+
+    if (random() % 10 < 6) {
+      switch (opcode >> 12u) {
+        case 0x0: opcode = ZERO_OPS[random() % 3]; break;
+        case 0x1:
+        case 0x2:
+          opcode = (opcode & 0xF000u) |
+                   (START_ADDRESS + 2 * (random() % length));
+          break;
+        case 0xF: opcode = (opcode & 0xFF00u) | FX_LOW[random() % 9]; break;
+        default: break;
+      }
+    }
+
+    rom.bytes.push_back(static_cast<uint8_t>(opcode >> 8u));
+    rom.bytes.push_back(static_cast<uint8_t>(opcode));
+  }
+
+  rom.quirks = static_cast<QuirkProfile>(random() % 4);
+  return rom;
+}
+
+// `lanes` machines of `rom` under `profile`, batched and one by one;
+// false (and a report) on the first lane that differs after a frame
+static bool Compare(char const* name, RomImage const& rom,
+                    QuirkProfile profile, bool vectorized, unsigned int lanes,
+                    unsigned int frames, unsigned int instructions,
+                    std::mt19937& random) {
+  Chip8 prototype;
+  prototype.LoadRom(rom);
+  prototype.SetQuirks(profile);
+
+  BatchCore batch(prototype, lanes);
+  batch.SetVectorized(vectorized);
+
+  std::vector<Chip8> machines(lanes, prototype);
+
+  for (unsigned int lane = 0; lane < lanes; ++lane) {
+    machines[lane].Seed(1000 + lane);
+    batch.Seed(lane, 1000 + lane);
+  }
+
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    for (unsigned int lane = 0; lane < lanes; ++lane) {
+      // Keys change now and then -> Ex9E/ExA1 branch apart, Fx0A resumes
+      if (random() % 8 == 0) {
+        uint8_t keys[16]{};
+
+        if (random() % 3 == 0) {
+          keys[random() % 16] = 1;
+        }
+
+        std::memcpy(machines[lane].keypad8_16, keys, sizeof(keys));
+        batch.SetKeys(lane, keys);
+      }
+
+      machines[lane].StepFrame(instructions);
+    }
+
+    batch.StepFrame(instructions);
+
+    for (unsigned int lane = 0; lane < lanes; ++lane) {
+      Chip8State state;
+      batch.Save(lane, state);
+
+      if (!Same(state, machines[lane])) {
+        std::cerr << name << " (" << QuirkProfileName(profile)
+                  << (batch.Vectorized() ? ", avx2" : ", scalar")
+                  << "): frame " << frame << ", lane " << lane << " differs\n";
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+int main() {
+  std::mt19937 random(1);
+  unsigned int runs = 0;
+
+  for (bool vectorized : {true, false}) {
+    for (char const* path : TEST_ROMS) {
+      std::shared_ptr<RomImage const> rom = RomCache::Global().Load(path);
+
+      if (rom == nullptr) {
+        std::cerr << "Cannot load ROM: " << path << "\n";
+        return EXIT_FAILURE;
+      }
+
+      for (QuirkProfile profile : ALL_QUIRK_PROFILES) {
+        if (!Compare(path, *rom, profile, vectorized, TEST_LANES, TEST_FRAMES,
+                     TEST_INSTRUCTIONS_PER_FRAME, random)) {
+          return EXIT_FAILURE;
+        }
+
+        ++runs;
+      }
+    }
+
+    for (unsigned int i = 0; i < TEST_RANDOM_ROMS; ++i) {
+      RomImage rom = RandomRom(random);
+
+      if (!Compare("random ROM", rom, rom.quirks, vectorized,
+                   1 + random() % 70, TEST_RANDOM_FRAMES, 1 + random() % 40,
+                   random)) {
+        return EXIT_FAILURE;
+      }
+
+      ++runs;
+    }
+  }
+
+  BatchCore probe(Chip8{}, 1);
+  std::cout << "batch core: " << runs << " runs ok"
+            << (probe.Vectorized() ? "" : " (no AVX2: scalar path only)")
+            << "\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+// Every core against the table interpreter, frame by frame: the sample ROMs
+// (recompiled for AotCore by the test build) under every quirk profile and
+// random programs (interpreted by AotCore), each core once with skip_idle on
+// and once off. The reference runs every pass (skip_idle off); after each
+// frame the Chip8State and the instruction count StepFrame returns must
+// match it. `make test` (from Chip8/); exit 1 on mismatch.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "aot_core.h"
+#include "chip_8.h"
+#include "fleet.h"
+#include "jit_core.h"
+#include "predecoded_core.h"
+#include "quirks.h"
+#include "rom_cache.h"
+
+const unsigned int TEST_FRAMES = 2000;
+const unsigned int TEST_INSTRUCTIONS_PER_FRAME = 15;
+const uint64_t TEST_SEED = 3;
+const unsigned int TEST_RANDOM_ROMS = 300;
+const unsigned int TEST_RANDOM_FRAMES = 30;
+
+static char const* const TEST_ROMS[] = {
+    "roms/sample_roms/IBM_Logo.ch8", "roms/sample_roms/Space_Invaders.ch8",
+    "roms/sample_roms/Tetris.ch8"};
+
+// Field by field: Chip8State has padding, so no memcmp of the whole struct
+static bool Same(Chip8State const& a, Chip8State const& b) {
+  return std::memcmp(a.registers8_16, b.registers8_16,
+                     sizeof(a.registers8_16)) == 0 &&
+         std::memcmp(a.memory8_4kb, b.memory8_4kb, sizeof(a.memory8_4kb)) ==
+             0 &&
+         a.index16 == b.index16 && a.pc16 == b.pc16 &&
+         std::memcmp(a.stack16_16, b.stack16_16, sizeof(a.stack16_16)) == 0 &&
+         a.sp8 == b.sp8 && a.delay_timer8 == b.delay_timer8 &&
+         a.sound_timer8 == b.sound_timer8 &&
+         std::memcmp(a.keypad8_16, b.keypad8_16, sizeof(a.keypad8_16)) == 0 &&
+         a.key_wait8 == b.key_wait8 &&
+         std::memcmp(a.video64_32, b.video64_32, sizeof(a.video64_32)) == 0 &&
+         a.opcode16 == b.opcode16 && a.random64 == b.random64;
+}
+
+// Mostly well-formed opcodes (jumps and calls inside the program, stores
+// that rewrite it) with some raw words mixed in
+static RomImage RandomRom(std::mt19937& random) {
+  static uint8_t const FX_LOW[] = {0x07, 0x0A, 0x15, 0x18, 0x1E,
+                                   0x29, 0x33, 0x55, 0x65};
+  static uint8_t const ALU_LOW[] = {0x0, 0x1, 0x2, 0x3, 0x4,
+                                    0x5, 0x6, 0x7, 0xE};
+  static uint16_t const ZERO_OPS[] = {0x00E0, 0x00EE, 0x0123};
+
+  RomImage rom;
+  unsigned int length = 20 + random() % 60;
+
+  for (unsigned int i = 0; i < length; ++i) {
+    uint16_t opcode = static_cast<uint16_t>(random());
+
+    if (random() % 10 < 6) {
+      switch (opcode >> 12u) {
+        case 0x0: opcode = ZERO_OPS[random() % 3]; break;
+        case 0x1:
+        case 0x2:
+        case 0xA:
+          opcode = (opcode & 0xF000u) |
+                   (START_ADDRESS + 2 * (random() % length));
+          break;
+        case 0x8: opcode = (opcode & 0xFFF0u) | ALU_LOW[random() % 9]; break;
+        case 0xF: opcode = (opcode & 0xFF00u) | FX_LOW[random() % 9]; break;
+        default: break;
+      }
+    }
+
+    rom.bytes.push_back(static_cast<uint8_t>(opcode >> 8u));
+    rom.bytes.push_back(static_cast<uint8_t>(opcode));
+  }
+
+  rom.quirks = static_cast<QuirkProfile>(random() % 4);
+  return rom;
+}
+
+// One Chip8 stepped by `core`; ROM and quirks set before the core caches
+// any code
+class Machine {
+ public:
+  Machine(CoreKind core, RomImage const& rom, QuirkProfile profile,
+          bool skip_idle)
+      : core(core) {
+    chip8.Seed(TEST_SEED);
+    chip8.skip_idle = skip_idle;
+    chip8.LoadRom(rom);
+    chip8.SetQuirks(profile);
+
+    switch (core) {
+      case CORE_TABLE: break;
+      case CORE_PREDECODED:
+        predecoded = std::make_unique<PredecodedCore>(chip8);
+        break;
+      case CORE_JIT: jit = std::make_unique<JitCore>(chip8); break;
+      case CORE_AOT: aot = std::make_unique<AotCore>(chip8); break;
+    }
+  }
+
+  bool AotNative() const { return aot != nullptr && aot->Native(); }
+
+  unsigned int StepFrame(unsigned int instructions) {
+    switch (core) {
+      case CORE_TABLE: return chip8.StepFrame(instructions);
+      case CORE_PREDECODED: return predecoded->StepFrame(instructions);
+      case CORE_JIT: return jit->StepFrame(instructions);
+      case CORE_AOT: return aot->StepFrame(instructions);
+    }
+
+    return 0;
+  }
+
+  Chip8 chip8;
+
+ private:
+  CoreKind core;
+  std::unique_ptr<PredecodedCore> predecoded;
+  std::unique_ptr<JitCore> jit;
+  std::unique_ptr<AotCore> aot;
+};
+
+// `core` against the table reference on one ROM and profile; false (and a
+// report) on the first frame that differs
+static bool Compare(char const* path, RomImage const& rom,
+                    QuirkProfile profile, CoreKind core, bool skip_idle,
+                    unsigned int frames, unsigned int instructions) {
+  Machine reference(CORE_TABLE, rom, profile, false);
+  Machine machine(core, rom, profile, skip_idle);
+
+  for (unsigned int frame = 0; frame < frames; ++frame) {
+    // One key at a time, then none -> Ex9E/ExA1 both ways, Fx0A resumes
+    unsigned int key = frame / 7 % 17;
+
+    for (unsigned int i = 0; i < 16; ++i) {
+      reference.chip8.keypad8_16[i] = machine.chip8.keypad8_16[i] = i == key;
+    }
+
+    unsigned int expected = reference.StepFrame(instructions);
+    unsigned int ran = machine.StepFrame(instructions);
+
+    if (ran != expected || !Same(machine.chip8, reference.chip8)) {
+      std::cerr << path << " (" << CoreName(core) << ", "
+                << QuirkProfileName(profile)
+                << (skip_idle ? ", skip_idle" : "") << "): frame " << frame
+                << " differs (pc " << machine.chip8.pc16 << " vs "
+                << reference.chip8.pc16 << ", ran " << ran << " vs "
+                << expected << ")\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main() {
+  std::mt19937 random(1);
+  unsigned int runs = 0;
+
+  for (char const* path : TEST_ROMS) {
+    std::shared_ptr<RomImage const> rom = RomCache::Global().Load(path);
+
+    if (rom == nullptr) {
+      std::cerr << "Cannot load ROM: " << path << "\n";
+      return EXIT_FAILURE;
+    }
+
+    // Under its own profile (the one compiled in) AotCore must run natively
+    if (!Machine(CORE_AOT, *rom, rom->quirks, false).AotNative()) {
+      std::cerr << path << ": no AOT program linked in (stale test build?)\n";
+      return EXIT_FAILURE;
+    }
+
+    for (QuirkProfile profile : ALL_QUIRK_PROFILES) {
+      for (CoreKind core : ALL_CORES) {
+        for (bool skip_idle : {false, true}) {
+          if (!Compare(path, *rom, profile, core, skip_idle, TEST_FRAMES,
+                       TEST_INSTRUCTIONS_PER_FRAME)) {
+            return EXIT_FAILURE;
+          }
+
+          ++runs;
+        }
+      }
+    }
+  }
+
+  for (unsigned int i = 0; i < TEST_RANDOM_ROMS; ++i) {
+    RomImage rom = RandomRom(random);
+    unsigned int instructions = 1 + random() % 40;
+
+    for (CoreKind core : ALL_CORES) {
+      for (bool skip_idle : {false, true}) {
+        if (!Compare("random ROM", rom, rom.quirks, core, skip_idle,
+                     TEST_RANDOM_FRAMES, instructions)) {
+          return EXIT_FAILURE;
+        }
+
+        ++runs;
+      }
+    }
+  }
+
+  std::cout << "equivalence: " << runs << " runs ok"
+            << (CHIP8_JIT_SUPPORTED ? "" : " (no JIT: interpreted)") << "\n";
+  return EXIT_SUCCESS;
+}
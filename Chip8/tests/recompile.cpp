@@ -0,0 +1,24 @@
+// `chip8 --recompile <ROM> <Out.cpp>` without SDL: the test build recompiles
+// the equivalence test's ROMs with it, so AotCore runs them natively
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "aot_compiler.h"
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <ROM> <Out.cpp>\n";
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out(argv[2]);
+
+  if (!out.is_open() || !RecompileRom(argv[1], out)) {
+    std::cerr << "Cannot recompile " << argv[1] << " into " << argv[2] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
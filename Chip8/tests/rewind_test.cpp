@@ -0,0 +1,80 @@
+// Push/StepBack round trip of RewindBuffer against plain snapshots: random
+// frames, unchanged frames (empty deltas) and steps back, in a ring small
+// enough to wrap and evict all the time. `make test`; exit 1 on mismatch.
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+
+#include "chip_8.h"
+#include "rewind.h"
+
+const unsigned int TEST_OPERATIONS = 200000;
+
+static Chip8State Snapshot(Chip8 const& chip8) {
+  Chip8State state;
+  chip8.SaveState(state);
+  return state;
+}
+
+static bool Same(Chip8State const& a, Chip8State const& b) {
+  return std::memcmp(&a, &b, sizeof(Chip8State)) == 0;
+}
+
+int main() {
+  std::mt19937 random(1);
+  Chip8 chip8;
+
+  // Random program; ops 0xF00A..0xFF0A among them halt it now and then
+  for (std::size_t i = 0; i < MAX_ROM_SIZE; ++i) {
+    chip8.memory8_4kb[START_ADDRESS + i] = static_cast<uint8_t>(random());
+  }
+
+  RewindBuffer rewind(0, 8);  // smallest ring -> wraps every few frames
+  std::deque<Chip8State> expected;  // one per record, oldest first
+
+  for (unsigned int op = 0; op < TEST_OPERATIONS; ++op) {
+    unsigned int action = random() % 8;
+
+    if (action < 2 && expected.size() >= 2) {
+      if (!rewind.StepBack(chip8)) {
+        std::cerr << "op " << op << ": StepBack refused\n";
+        return EXIT_FAILURE;
+      }
+
+      expected.pop_back();
+
+      if (!Same(Snapshot(chip8), expected.back())) {
+        std::cerr << "op " << op << ": StepBack state differs\n";
+        return EXIT_FAILURE;
+      }
+
+      continue;
+    }
+
+    if (action >= 4) {
+      std::memset(chip8.keypad8_16, 0, sizeof(chip8.keypad8_16));
+      chip8.keypad8_16[random() % 16] = random() % 2;
+      chip8.StepFrame(random() % 16);
+    }  // else: same state again -> empty delta
+
+    rewind.Push(chip8);
+    expected.push_back(Snapshot(chip8));
+
+    // Eviction drops whole groups from the old end
+    while (expected.size() > rewind.Frames()) {
+      expected.pop_front();
+    }
+
+    if (rewind.BytesUsed() > rewind.Capacity()) {
+      std::cerr << "op " << op << ": " << rewind.BytesUsed()
+                << " bytes used > capacity\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "rewind: " << TEST_OPERATIONS << " operations ok\n";
+  return EXIT_SUCCESS;
+}